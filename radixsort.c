@@ -1,575 +1,5065 @@
-//    A reasonably simple and efficient radix sort implementation in C++.
-//    Version 1.02.
-//
-//    Development threads:
-// https://gamedev.ru/flame/forum/?id=227644
-// https://www.gamedev.net/forums/topic/701484-radix-sort-discussion/
-//
-// LICENSE
-//    This software is in the public domain. Where that dedication is not
-//    recognized, you are granted a perpetual, irrevocable license to copy
-//    and modify this file as you see fit.
-//
-// NOTES
-//    You may want to treat this as a copy-paste fodder, rather than a proper
-//    library, e. g. no effort has been made to prevent name clashes (e. g.
-//    via wrapping it in a namespace).
-//
-//    Templates introduce some code bloat, but may also increase
-//    opportunities for optimizations (there are also architectures
-//    that are not fond of variable shifts), and experimentally do help.
-//
-// OVERVIEW
-//    The library provides 2 template functions:
-//      template<typename T,typename Traits>
-//      T *radix_sort_stable(T *src,T* tmp,size_t n,int destination,int mode);
-//
-//      template<typename T,typename Traits>
-//      void radix_sort_inplace(T *src,size_t n);
-//
-//    Both functions operate on a contiguous array of objects T with unsigned
-//    integer key. The key for the type is determined by supplied 'Traits'
-//    template parameter, which should be a class with a public
-//    static 'get_key(const T&)' method. Key size is deduced form
-//    this method's return type. Example:
-//      struct KeyValue
-//      {
-//          uint32_t key;
-//          uint32_t index; // Preferable on x64 over void*.
-//      };
-//      struct GetKey
-//      {
-//          uint32_t get_key(const KeyValue &src) {return src.key;}
-//      };
-//      KeyValue *sorted=radix_sort_stable<KeyValue,GetKey>(buffer,n,-1,-1);
-//
-//    The above is expected to be most likely use-case. In case of 'fat' objects
-//    it is recommended to only store handle (index or pointer) to it in T, and
-//    store the objects themselves elsewhere. Anyway, it is strongly recommended,
-//    that T is either a fundamental type (e. g. unsigned int) or a simple
-//    struct (like POD ("plain old data"); at least DefaultConstructible might
-//    be mandatory). Of course, sorting pure keys (treating entire T as a key)
-//    works as well. For the typical cases of sorting signed integers and floats
-//    according to their natural ordering you may use the following helper
-//    functions (while you MAY use them as Traits::get_key, you are better off
-//    constructing input with unsigned keys separately, performance-wise):
-//      uint32_t make_key_from_signed(int32_t x) {
-//          return uint32_t(x)-uint32_t(INT32_MIN);
-//      }
-//      uint32_t make_key_from_float(float x) {
-//          uint32_t ret;
-//          memcpy(&ret,&x,sizeof(ret));
-//          ret=ret^(uint32_t(int32_t(ret)>>31)|uint32_t(0x80000000ul));
-//          return ret-0x007FFFFFul; // Place all NaNs at the top.
-//      }
-//    and similarly for other sizes. make_key_from_signed() may even work
-//    in non 2's complement integers (if the C++ Standard is to be believed,
-//    signed->unsigned is numerical_value mod 2^word_size). The function
-//    make_key_from_float() requires float to be IEEE-754 binary floating
-//    point type (binary32), and needs the endianness of uint and float
-//    to agree, so that float's sign bit goes to msb; it also relies on
-//    signed right shift sign-extending (both assumptions hold on x86/x64).
-//    If you rather have all NaNs at the bottom (i. e. comparing less to
-//    all other floats) you can 'return ret-0x007FFFFFul;'. And if you
-//    don't mind NaNs being on both sides, you can just 'return ret;'.
-//    For double, the corresponding constant is 0x000FFFFFFFFFFFFFull
-//    (i. e. 2^52-1).
-//
-//    You can return bitwise NOT of key, to sort in descending order.
-//
-//    The radix_sort_stable() performs a stable sort, using additional
-//    buffer 'tmp' (n elements in size), supplied by the caller (it does
-//    not dynamically allocate anything). Argument 'destination' controls
-//    where the output is written:
-//      0 - 'src'
-//      1 - 'tmp'
-//      anything else means 'don't care' (may be faster)
-//    The function returns pointer to output (equal to either 'src' or 'tmp').
-//    Argument 'mode' controls which type of algorithm is used:
-//      0 - LSD radix sort (least significant digit is sorted first)
-//      1 - MSD radix sort (most significant digit is sorted first)
-//      anything else means 'don't care' (decided via heuristic for speed)
-//    The function uses O(sizeof(key)) additional memory (it may use recursion,
-//    but the depth is bounded by the above value), which is around 64KB in
-//    practice on x64.
-//
-//    The radix_sort_inplace() performs inplace sort (which is not stable).
-//    It does not allocate anything dynamically, and uses O(sizeof(T))
-//    additional memory, which is around 64KB in practice on x64 (more
-//    for larger T).
-//
-//    Memory usage for both functions can be improved, with a modest
-//    performance hit.
-//
-// COMPILING
-//    The code compiles as C++03. Implementing this in pure C seems doable,
-//    and probably rather simple, especially if restricted to byte
-//    granularity. No attempt was made here to do so.
-//
-// PERFORMANCE
-//    For smaller (<=32b) keys the radix_sort_stable() is generally faster,
-//    for most input sizes, sometimes twice as fast. For larger keys
-//    radix_sort_inplace() starts to catch up, and sometimes is faster.
-//    On small (<=32b) keys both functions should outperform std::sort
-//    significantly, except for small (n<500) inputs, where they are
-//    about the same. On x64 for {uint32_t key; uint32_t index} the
-//    radix_sort_stable() is typically x4 and radix_sort_inplace() is
-//    typically x2.5 faster than std::sort. Performance drops for
-//    larger sizeof(key), and in general for larger sizeof(T).
-//    Performance varies somewhat significantly, depending on platform.
-//    The functions were tuned for typical x64. You are welcome to tweak them
-//    for platforms that matter to you.
-//    Compiler optimizations beyond (equivalent of) -O2 do not seem to
-//    affect performance much (even -O1 seems to run at the same speed
-//    as -O2; -O0 does slow sorting down a lot (~x3), though).
-//
-//    For random keys, the performance does not seem to depend on
-//    whether the input is already sorted (std::sort is a lot faster
-//    in that case, so the win is marginal).
-//    Performance DOES depend a lot on the structure of data. E. g. if
-//    the keys are a sequence 0..(n-1), the performance drops x3 (apparently
-//    due to the lot of power-of-two sized buckets causing cache aliasing).
-//    The effect is present even if the input is shuffled (though to a lesser
-//    degree). No attempt is made to detect this situation. The MSD radix sort
-//    is less affected, so you might want to force that, if this situation
-//    is likely.
-//
-// PREFETCHING
-//    Experimentally, prefetching was found to help quite a bit (specifics
-//    depend on a platform), so the library does use it. It tries to do so
-//    without causing a hassle, but if it turns out problematic for you (be it
-//    compilation errors, performance degradation or something else) you may
-//    opt to replace or outright remove it (it should only impact performance).
-
-#include <cstddef> // For size_t.
-#include <climits> // For CHAR_BIT.
-
-// Simple and hopefully unproblematic prefetching.
-#if defined(__GNUC__) // GCC, clang, or icc.
-static inline void radixsort_prefetch(const void *p)
-{
-    __builtin_prefetch(p,0,3);
-}
-#elif defined(__SSE__) || (defined(_M_IX86_FP) && (_M_IX86_FP>0)) || defined(_M_AMD64) || defined(_M_X64)
-// x86/x64, hopefully compiler understands intrinsics.
-#include <xmmintrin.h>
-static inline void radixsort_prefetch(const void *p)
-{
-    _mm_prefetch((const char*)p,_MM_HINT_T0);
-}
-#else // Short on luck, no-op.
-static inline void radixsort_prefetch(const void *p)
-{
-    (void)p;
-}
-#endif
-
-// This function is here to satisfy the C++ Standard.
-// Merely creating out-of-bounds pointer via address arithmetic is
-// undefined behavior, but creating it via conversion from
-// integer is implementation-defined.
-// The prefetch itself does accept invalid address.
-// If we don't have large enough integer type to hold void*,
-// then we test for out-of-bounds. This does not seem to impact
-// performance much, but removing the test is very unlikely to cause
-// problems in practice, despite being technically UB.
-#if __cplusplus>=201103L // C++11. We have <cstdint>.
-#include <cstdint>
-#ifdef UINTPTR_MAX       // We have uintptr_t.
-static inline void radixsort_lookahead(const void *p,std::size_t delta)
-{
-    (void)delta;
-    radixsort_prefetch((const void*)(std::uintptr_t(p)+16));
-}
-#else
-static inline void radixsort_lookahead(const void *p,std::size_t delta)
-{
-    if(sizeof(std::size_t)>=sizeof(void*)) radixsort_prefetch((const void*)(std::size_t(p)+16));
-    else if(delta<16) radixsort_prefetch((const char*)(p)+16);
-}
-#endif
-#else
-static inline void radixsort_lookahead(const void *p,std::size_t delta)
-{
-    if(sizeof(std::size_t)>=sizeof(void*)) radixsort_prefetch((const void*)(std::size_t(p)+16));
-    else if(delta<16) radixsort_prefetch((const char*)(p)+16);
-}
-#endif
-
-// Internal functions.
-
-// Fallback sort, used by MSD radix sort on small (~256) inputs.
-// Simple out-of-place merge sort, which further falls back
-// to insertion sort for smaller (~18) inputs.
-template<typename T,typename Traits>
-static inline T *fallback_sort(T *src,T *tmp,std::size_t n,int destination)
-{
-    using std::size_t;
-    T *d=(destination==0?src:tmp);
-    // 18 is an experimentally chosen threshold.
-    if(n<=18) // Insertion sort.
-    {
-        if(n>0) d[0]=src[0];
-        for(size_t i=1;i<n;++i)
-        {
-            T t=src[i];
-            size_t j=i;
-            for(;j>0&&Traits::get_key(t)<Traits::get_key(d[j-1]);--j) d[j]=d[j-1];
-            d[j]=t;
-        }
-        return d;
-    }
-    size_t a=n/2,b=n-a;
-    fallback_sort<T,Traits>(src,tmp,a,!destination);
-    fallback_sort<T,Traits>(src+a,tmp+a,b,!destination);
-    const T *l=(destination==0?tmp:src);
-    const T *r=l+a;
-    size_t i=0,j=0,k=0;
-    while(true)
-    {
-        if(Traits::get_key(r[j])<Traits::get_key(l[i])) {d[k++]=r[j++]; if(j==b) break;}
-        else                                            {d[k++]=l[i++]; if(i==a) break;}
-    }
-    if(i==a) while(j<b) d[k++]=r[j++];
-    else     while(i<a) d[k++]=l[i++];
-    return d;
-}
-
-// Sort an array according to its WIDTH lower bits, in radix of (1<<BITS).
-template<typename T,std::size_t WIDTH,std::size_t BITS,std::size_t THRESHOLD,typename Traits>
-static inline T *radix_sort_msd_impl(T *src,T *dst,std::size_t n,int destination)
-{
-    using std::size_t;
-    static const size_t LOG2SIZE=(BITS<WIDTH?BITS:WIDTH);
-    static const size_t SIZE=1u<<LOG2SIZE;
-    static const size_t OFFSET=WIDTH-LOG2SIZE;
-    static const size_t MASK=SIZE-1;
-    if(n<THRESHOLD) return fallback_sort<T,Traits>(src,dst,n,destination);
-    size_t c[2*SIZE]={0};
-    // Cumulative distribution function. Unrolled x2 to mitigate store->load hit.
-    for(size_t i=0,m=n/2;i<m;++i)
-    {
-        size_t k0=size_t(Traits::get_key(src[2*i  ])>>OFFSET)&MASK;
-        size_t k1=size_t(Traits::get_key(src[2*i+1])>>OFFSET)&MASK;
-        ++c[2*k0  ];
-        ++c[2*k1+1];
-    }
-    if(n&1) ++c[2*(size_t(Traits::get_key(src[n-1])>>OFFSET)&MASK)];
-    for(size_t j=0,s=0,t;j<SIZE;++j) {t=s; s+=c[2*j]+c[2*j+1]; c[j]=t;}
-    for(size_t j=0;j+1<SIZE;++j)
-        if(c[j+1]-c[j]==n) // All keys are in the same bucket.
-        {
-            T *tmp=src;src=dst;dst=tmp;
-            destination^=1;
-            goto skip;
-        }
-    // Scatter.
-    for(size_t i=0;i<n;++i)
-    {
-        size_t k=size_t(Traits::get_key(src[i])>>OFFSET)&MASK;
-        radixsort_lookahead(dst+c[k],(n-c[k])*sizeof(T));
-        dst[c[k]++]=src[i];
-    }
-skip:;
-    T *out=(destination==0?src:dst);
-    if(OFFSET>0)
-        for(size_t j=0,b=0;j<SIZE;b=c[j++])
-            switch(c[j]-b)
-            {
-                case 0: break;
-                case 1: out[b]=dst[b]; break;
-                case 2:
-                {
-                    bool flip=(Traits::get_key(dst[b+1])<Traits::get_key(dst[b]));
-                    T L=dst[b+flip],H=dst[b+!flip];
-                    out[b]=L; out[b+1]=H;
-                    break;
-                }
-                default: radix_sort_msd_impl<T,(OFFSET>0?OFFSET:WIDTH),BITS,THRESHOLD,Traits>(dst+b,src+b,c[j]-b,destination^1);
-            }
-    if(OFFSET==0&&destination==0) for(size_t i=0;i<n;++i) src[i]=dst[i];
-    return out;
-}
-
-// Sort an array according to its WIDTH upper bits, in radix of (1<<BITS).
-template<typename T,std::size_t WIDTH,std::size_t BITS,typename Traits>
-static inline T *radix_sort_lsd_impl(T *src,T *dst,std::size_t n)
-{
-    using std::size_t;
-    static const size_t OFFSET=sizeof(Traits::get_key(*src))*CHAR_BIT-WIDTH;
-    static const size_t SIZE=1u<<(BITS<WIDTH?BITS:WIDTH);
-    static const size_t MASK=SIZE-1;
-    size_t c[2*SIZE]={0};
-    // Cumulative distribution function. Unrolled x2 to mitigate store->load hit.
-    for(size_t i=0,m=n/2;i<m;++i)
-    {
-        size_t k0=size_t(Traits::get_key(src[2*i  ])>>OFFSET)&MASK;
-        size_t k1=size_t(Traits::get_key(src[2*i+1])>>OFFSET)&MASK;
-        ++c[2*k0  ];
-        ++c[2*k1+1];
-    }
-    if(n&1) ++c[2*(size_t(Traits::get_key(src[n-1])>>OFFSET)&MASK)];
-    for(size_t j=0,s=0,t;j<SIZE;++j) {t=s; s+=c[2*j]+c[2*j+1]; c[j]=t;}
-    for(size_t j=0;j+1<SIZE;++j)
-        if(c[j+1]-c[j]==n) // All keys are in the same bucket.
-        {
-            T *tmp=src;src=dst;dst=tmp;
-            goto skip;
-        }
-    // Scatter.
-    for(size_t i=0;i<n;++i)
-    {
-        size_t k=size_t(Traits::get_key(src[i])>>OFFSET)&MASK;
-        radixsort_lookahead(dst+c[k],(n-c[k])*sizeof(T));
-        dst[c[k]++]=src[i];
-    }
-skip:;
-    // Conditionals are to stop template expansion recursion.
-    if(BITS<WIDTH) return radix_sort_lsd_impl<T,(BITS<WIDTH?WIDTH-BITS:WIDTH),BITS,Traits>(dst,src,n);
-    return dst;
-}
-
-// Sort an array according to its WIDTH lower bits, in radix of (1<<BITS).
-template<typename T,std::size_t WIDTH,std::size_t BITS,std::size_t THRESHOLD,typename Traits>
-static inline void radix_sort_msd_inplace_impl(T *src,std::size_t n)
-{
-    using std::size_t;
-    static const size_t LOG2SIZE=(BITS<WIDTH?BITS:WIDTH);
-    static const size_t SIZE=1u<<LOG2SIZE;
-    static const size_t OFFSET=WIDTH-LOG2SIZE;
-    static const size_t MASK=SIZE-1;
-    if(n<THRESHOLD)
-    {
-        T tmp[THRESHOLD];
-        fallback_sort<T,Traits>(src,tmp,n,0);
-        return;
-    }
-    size_t c[2*SIZE]={0},*d=c+SIZE;
-    // Cumulative distribution function. Unrolled x2 to mitigate store->load hit.
-    for(size_t i=0,m=n/2;i<m;++i)
-    {
-        size_t k0=size_t(Traits::get_key(src[2*i  ])>>OFFSET)&MASK;
-        size_t k1=size_t(Traits::get_key(src[2*i+1])>>OFFSET)&MASK;
-        ++c[2*k0  ];
-        ++c[2*k1+1];
-    }
-    if(n&1) ++c[2*(size_t(Traits::get_key(src[n-1])>>OFFSET)&MASK)];
-    for(size_t j=0,s=0,t;j<SIZE;++j) {t=s; s+=c[2*j]+c[2*j+1]; c[j]=t;}
-    for(size_t j=0;j+1<SIZE;++j) d[j]=c[j+1];
-    d[SIZE-1]=n;
-    for(size_t j=0;j+1<SIZE;++j)
-        if(c[j+1]-c[j]==n) // All keys are in the same bucket.
-            goto skip;
-    // Scatter.
-    for(size_t j=0;j<SIZE;++j)
-        for(;c[j]!=d[j];++c[j])
-        {
-            size_t k=c[j],h=size_t(Traits::get_key(src[k])>>OFFSET)&MASK;
-            while(j!=h)
-            {
-                T t=src[c[h]];
-                radixsort_lookahead(src+c[h],(n-c[h])*sizeof(T));
-                src[c[h]++]=src[k];
-                src[k]=t;
-                h=size_t(Traits::get_key(t)>>OFFSET)&MASK;
-            }
-        }
-skip:;
-    if(OFFSET>0)
-        for(size_t j=0,b=0;j<SIZE;b=d[j++])
-            switch(d[j]-b)
-            {
-                case 0:
-                case 1: break;
-                case 2: if(Traits::get_key(src[b+1])<Traits::get_key(src[b])) {T tmp=src[b+1];src[b+1]=src[b];src[b]=tmp;} break;
-                default: radix_sort_msd_inplace_impl<T,(OFFSET>0?OFFSET:WIDTH),BITS,THRESHOLD,Traits>(src+b,d[j]-b); break;
-            }
-}
-
-// MSD and LSD out-of-place versions of radix sort.
-// Used internally by radix_sort_stable(), but are usable as is, with
-// somewhat decent performance.
-
-template<typename T,std::size_t BITS,std::size_t THRESHOLD,typename Traits>
-static inline T *radix_sort_msd(T *src,T *tmp,std::size_t n,int destination)
-{
-    if(destination!=1) destination=0;
-    return radix_sort_msd_impl<T,sizeof(Traits::get_key(*src))*CHAR_BIT,BITS,THRESHOLD,Traits>(src,tmp,n,destination);
-}
-
-template<typename T,std::size_t BITS,typename Traits>
-static inline T *radix_sort_lsd(T *src,T *tmp,std::size_t n,int destination)
-{
-    using std::size_t;
-    T *ret=radix_sort_lsd_impl<T,sizeof(Traits::get_key(*src))*CHAR_BIT,BITS,Traits>(src,tmp,n);
-    if(destination==0&&ret!=src) {ret=src; for(size_t i=0;i<n;++i) src[i]=tmp[i];}
-    if(destination==1&&ret!=tmp) {ret=tmp; for(size_t i=0;i<n;++i) tmp[i]=src[i];}
-    return ret;
-}
-
-// Exported (API) functions.
-
-template<typename T,typename Traits>
-inline T *radix_sort_stable(T *src,T* tmp,std::size_t n,int destination,int mode)
-{
-    // Generally, MSD is faster for:
-    //   * small inputs
-    //   * large keys
-    //   * large data on large inputs
-    // Also user may have explicitly asked for it.
-    // 1500 and 1000000 are experimentally chosen thresholds.
-    if(mode!=0&&(
-        mode==1||n<1500||
-        sizeof(Traits::get_key(*src))*CHAR_BIT>40||
-        (sizeof(T)*CHAR_BIT>64&&n>10000000ul/sizeof(T))))
-    {
-        size_t bits=8;
-        // Some experimantally chosen ranges.
-        if(n>4000u&&n<60000u) bits=11;
-        if(n>2000000ul&&n<9000000ul) bits=11;
-        if(bits==8) return radix_sort_msd<T, 8,128,Traits>(src,tmp,n,destination);
-        else        return radix_sort_msd<T,11,256,Traits>(src,tmp,n,destination);
-    }
-
-    // Otherwise, return LSD.
-    return radix_sort_lsd<T,8,Traits>(src,tmp,n,destination);
-}
-
-template<typename T,typename Traits>
-inline void radix_sort_inplace(T *src,std::size_t n)
-{
-    unsigned bits=8;
-    // Some experimantally chosen ranges.
-    if(n>4000u&&n<60000u) bits=11;
-    if(n>2000000ul&&n<9000000ul) bits=11;
-    if(bits==8) radix_sort_msd_inplace_impl<T,sizeof(Traits::get_key(*src))*CHAR_BIT, 8,128,Traits>(src,n);
-    else        radix_sort_msd_inplace_impl<T,sizeof(Traits::get_key(*src))*CHAR_BIT,11,256,Traits>(src,n);
-}
-
-//==============================================================================
-// Test harness.
-
-#include <cstdio>
-#include <cstdint>
-#include <algorithm>
-#include <random>
-#ifdef __GNUC__
-#include <x86intrin.h>
-#else
-#include <intrin.h>
-#endif
-
-using std::size_t;
-
-static const size_t MAX_N=20<<20;
-
-typedef std::uint32_t KeyType;
-typedef std::uint32_t ValueType;
-
-struct KV
-{
-    KeyType key;
-    ValueType index;
-    friend inline bool operator<(const KV &l,const KV &r) {return l.key<r.key;}
-};
-
-struct GetKey
-{
-    static inline KeyType get_key(const KV &src)
-    {
-        return src.key;
-    }
-};
-
-KV src[MAX_N],tmp[MAX_N],ref[MAX_N];
-
-static void gen(KV *dst,size_t n)
-{
-    std::minstd_rand rng(1);
-    std::uniform_int_distribution<KeyType> distr(0,KeyType(-1));
-    for(size_t i=0;i<n;++i)
-        dst[i]={distr(rng),std::uint32_t(i)};
-}
-
-template<KV* (*f)(KV*,KV*,size_t)>
-static void test(size_t n)
-{
-    uint64_t t=0,tm=std::uint64_t(-1);
-    size_t runs=12500/n+1;
-
-    std::minstd_rand rng(1);
-    std::uniform_int_distribution<std::uint32_t> distr(0,std::uint32_t(-1));
-    gen(ref,n);
-    std::stable_sort(ref,ref+n);
-
-    KV *res=src;
-    for(size_t k=0;k<runs;++k)
-    {
-        std::minstd_rand rng(1);
-        std::uniform_int_distribution<uint32_t> distr(0,std::uint32_t(-1));
-        gen(src,n);
-        t=__rdtsc();
-        res=f(src,tmp,n);
-        t=__rdtsc()-t;
-        if(t<tm) tm=t;
-    }
-    bool srt=true;
-    for(size_t i=0;i<n;++i) if(res[i].key!=ref[i].key) {srt=false;break;}
-    bool stb=true;
-    for(size_t i=0;i<n;++i) if(res[i].key!=ref[i].key||res[i].index!=ref[i].index) {stb=false;break;}
-
-    char buf[16];
-    double ret=double(t)/double(n);
-    t=tm;
-    std::sprintf(buf,"%5.0f",ret);
-    std::printf("%6s%c%c",buf,"# "[srt],"~ "[stb]);
-    std::fflush(stdout);
-}
-
-static inline KV *std_sort_wrapper(KV* src,KV* tmp,size_t n)
-{
-    (void)tmp;
-    std::sort(src,src+n);
-    return src;
-}
-
-static inline KV *radix_sort_stable_wrapper(KV* src,KV* tmp,size_t n)
-{
-    return radix_sort_stable<KV,GetKey>(src,tmp,n,-1,-1);
-}
-
-static inline KV *radix_sort_inplace_wrapper(KV* src,KV* tmp,size_t n)
-{
-    (void)tmp;
-    radix_sort_inplace<KV,GetKey>(src,n);
-    return src;
-}
-
-int main()
-{
-    static const int N=9;
-    static const int C=190; // C/100 is size sequence multiplier.
-    int m=16;
-    std::printf("Timings are in cycles per element.\n");
-    for(int q=0;q<2;++q)
-    {
-        std::printf("%-29s","n");
-        for(int i=0,n=m;i<N;++i,n=C*n/100) std::printf("|%8d",n);
-        std::printf("\n");
-        std::printf("-----------------------------");
-        for(size_t i=0;i<N;++i) std::printf("+--------");
-        std::printf("\n");
-        std::printf("%-29s","std::sort");
-        for(int i=0,n=m;i<N;++i,n=C*n/100) {std::printf("|");test<std_sort_wrapper>(n);}
-        std::printf("\n");
-        std::printf("%-29s","radix_sort_stable");
-        for(int i=0,n=m;i<N;++i,n=C*n/100) {std::printf("|");test<radix_sort_stable_wrapper>(n);}
-        std::printf("\n");
-        std::printf("%-29s","radix_sort_inplace");
-        for(int i=0,n=m;i<N;++i,n=C*n/100) {std::printf("|");test<radix_sort_inplace_wrapper>(n);}
-        std::printf("\n");
-        for(int i=0;i<N;++i,m=C*m/100);
-        std::printf("\n");
-    }
-    return 0;
-}
+//    A reasonably simple and efficient radix sort implementation in C++.
+//    Version 1.02.
+//
+//    Development threads:
+// https://gamedev.ru/flame/forum/?id=227644
+// https://www.gamedev.net/forums/topic/701484-radix-sort-discussion/
+//
+// LICENSE
+//    This software is in the public domain. Where that dedication is not
+//    recognized, you are granted a perpetual, irrevocable license to copy
+//    and modify this file as you see fit.
+//
+// NOTES
+//    You may want to treat this as a copy-paste fodder, rather than a proper
+//    library, e. g. no effort has been made to prevent name clashes (e. g.
+//    via wrapping it in a namespace).
+//
+//    Templates introduce some code bloat, but may also increase
+//    opportunities for optimizations (there are also architectures
+//    that are not fond of variable shifts), and experimentally do help.
+//
+// OVERVIEW
+//    The library provides 2 template functions:
+//      template<typename T,typename Traits>
+//      T *radix_sort_stable(T *src,T* tmp,size_t n,int destination,int mode);
+//
+//      template<typename T,typename Traits>
+//      void radix_sort_inplace(T *src,size_t n);
+//
+//    Both functions operate on a contiguous array of objects T with unsigned
+//    integer key. The key for the type is determined by supplied 'Traits'
+//    template parameter, which should be a class with a public
+//    static 'get_key(const T&)' method. Key size is deduced form
+//    this method's return type. Example:
+//      struct KeyValue
+//      {
+//          uint32_t key;
+//          uint32_t index; // Preferable on x64 over void*.
+//      };
+//      struct GetKey
+//      {
+//          uint32_t get_key(const KeyValue &src) {return src.key;}
+//      };
+//      KeyValue *sorted=radix_sort_stable<KeyValue,GetKey>(buffer,n,-1,-1);
+//
+//    The above is expected to be most likely use-case. In case of 'fat' objects
+//    it is recommended to only store handle (index or pointer) to it in T, and
+//    store the objects themselves elsewhere. Anyway, it is strongly recommended,
+//    that T is either a fundamental type (e. g. unsigned int) or a simple
+//    struct (like POD ("plain old data"); at least DefaultConstructible might
+//    be mandatory). Of course, sorting pure keys (treating entire T as a key)
+//    works as well. For the typical cases of sorting signed integers and floats
+//    according to their natural ordering you may use the following helper
+//    functions (while you MAY use them as Traits::get_key, you are better off
+//    constructing input with unsigned keys separately, performance-wise):
+//      uint32_t make_key_from_signed(int32_t x) {
+//          return uint32_t(x)-uint32_t(INT32_MIN);
+//      }
+//      uint32_t make_key_from_float(float x) {
+//          uint32_t ret;
+//          memcpy(&ret,&x,sizeof(ret));
+//          ret=ret^(uint32_t(int32_t(ret)>>31)|uint32_t(0x80000000ul));
+//          return ret-0x007FFFFFul; // Place all NaNs at the top.
+//      }
+//    and similarly for other sizes. make_key_from_signed() may even work
+//    in non 2's complement integers (if the C++ Standard is to be believed,
+//    signed->unsigned is numerical_value mod 2^word_size). The function
+//    make_key_from_float() requires float to be IEEE-754 binary floating
+//    point type (binary32), and needs the endianness of uint and float
+//    to agree, so that float's sign bit goes to msb; it also relies on
+//    signed right shift sign-extending (both assumptions hold on x86/x64).
+//    If you rather have all NaNs at the bottom (i. e. comparing less to
+//    all other floats) you can 'return ret-0x007FFFFFul;'. And if you
+//    don't mind NaNs being on both sides, you can just 'return ret;'.
+//    For double, the corresponding constant is 0x000FFFFFFFFFFFFFull
+//    (i. e. 2^52-1).
+//
+//    You can return bitwise NOT of key, to sort in descending order.
+//
+//    The radix_sort_stable() performs a stable sort, using additional
+//    buffer 'tmp' (n elements in size), supplied by the caller (it does
+//    not dynamically allocate anything). Argument 'destination' controls
+//    where the output is written:
+//      0 - 'src'
+//      1 - 'tmp'
+//      anything else means 'don't care' (may be faster)
+//    The function returns pointer to output (equal to either 'src' or 'tmp').
+//    Argument 'mode' controls which type of algorithm is used:
+//      0 - LSD radix sort (least significant digit is sorted first)
+//      1 - MSD radix sort (most significant digit is sorted first)
+//      anything else means 'don't care' (decided via heuristic for speed)
+//    The function uses O(sizeof(key)) additional memory (it may use recursion,
+//    but the depth is bounded by the above value), which is around 64KB in
+//    practice on x64.
+//
+//    The radix_sort_inplace() performs inplace sort (which is not stable).
+//    It does not allocate anything dynamically, and uses O(sizeof(T))
+//    additional memory, which is around 64KB in practice on x64 (more
+//    for larger T).
+//
+//    Memory usage for both functions can be improved, with a modest
+//    performance hit.
+//
+// COMPILING
+//    The code compiles as C++03. Implementing this in pure C seems doable,
+//    and probably rather simple, especially if restricted to byte
+//    granularity. No attempt was made here to do so.
+//    libradixsort_lib.a (the C interface at the end of this file, used by
+//    the Crystal bindings) is built with -DRADIXSORT_STATS=1
+//    -DRADIXSORT_ASYNC=1, see the "lib" task in .vscode/tasks.json.
+//
+// PERFORMANCE
+//    For smaller (<=32b) keys the radix_sort_stable() is generally faster,
+//    for most input sizes, sometimes twice as fast. For larger keys
+//    radix_sort_inplace() starts to catch up, and sometimes is faster.
+//    On small (<=32b) keys both functions should outperform std::sort
+//    significantly, except for small (n<500) inputs, where they are
+//    about the same. On x64 for {uint32_t key; uint32_t index} the
+//    radix_sort_stable() is typically x4 and radix_sort_inplace() is
+//    typically x2.5 faster than std::sort. Performance drops for
+//    larger sizeof(key), and in general for larger sizeof(T).
+//    Performance varies somewhat significantly, depending on platform.
+//    The functions were tuned for typical x64. You are welcome to tweak them
+//    for platforms that matter to you.
+//    Compiler optimizations beyond (equivalent of) -O2 do not seem to
+//    affect performance much (even -O1 seems to run at the same speed
+//    as -O2; -O0 does slow sorting down a lot (~x3), though).
+//
+//    For random keys, the performance does not seem to depend on
+//    whether the input is already sorted (std::sort is a lot faster
+//    in that case, so the win is marginal).
+//    Performance DOES depend a lot on the structure of data. E. g. if
+//    the keys are a sequence 0..(n-1), the performance drops x3 (apparently
+//    due to the lot of power-of-two sized buckets causing cache aliasing).
+//    The effect is present even if the input is shuffled (though to a lesser
+//    degree). No attempt is made to detect this situation. The MSD radix sort
+//    is less affected, so you might want to force that, if this situation
+//    is likely.
+//
+// PREFETCHING
+//    Experimentally, prefetching was found to help quite a bit (specifics
+//    depend on a platform), so the library does use it. It tries to do so
+//    without causing a hassle, but if it turns out problematic for you (be it
+//    compilation errors, performance degradation or something else) you may
+//    opt to replace or outright remove it (it should only impact performance).
+//
+// VERIFICATION
+//    radix_sort_stable_verified() and radix_sort_inplace_verified() take
+//    the same arguments as the functions above, and additionally check the
+//    result, returning null (false) on failure: an order-independent
+//    checksum of keys is accumulated during the first histogram pass, and
+//    a single sequential scan of the output checks that it is ordered and
+//    that its keys have the same checksum (i. e. the output is, with high
+//    probability, a permutation of the input). Only keys take part in the
+//    checksum. The cost is one extra read of the output.
+//
+// PRECISION-LIMITED SORTING
+//    radix_sort_stable_top<T,B,Traits>() and radix_sort_inplace_top<T,B,Traits>()
+//    take the same arguments as the functions above, but only order by the
+//    top B bits of the key, e. g. 12-16 bits of a float depth. LSD takes
+//    ceil(B/8) passes instead of sizeof(key), MSD recursion stops after
+//    B bits. Keys equal in those bits count as ties (and keep their order
+//    in the stable version).
+//
+// BUCKET DIRECTORIES
+//    radix_sort_stable_directory() and radix_sort_inplace_directory() take
+//    an extra 'dir' argument of 257 offsets, which they fill from the
+//    histogram of the top digit: sorted elements with top 8 bits of key
+//    equal to b are [dir[b],dir[b+1]). radix_sort_directory() builds such
+//    a directory for any number of top bits, and
+//    radix_sort_directory_lower_bound()/upper_bound()/range() search only
+//    within the matching bucket.
+//
+// STATISTICS
+//    If RADIXSORT_STATS is defined to 1, every exported function records
+//    what it did into a radix_sort_stats struct: which algorithm was
+//    chosen, how many radix passes ran and how many were skipped (all keys
+//    in the same bucket), bytes written, fallback_sort() calls and depth
+//    of MSD recursion. Counters are updated per pass and per fallback
+//    call, never per element. The last call's stats and the running total
+//    are kept per thread (where thread-local storage is available), see
+//    radix_sort_stats_last(), radix_sort_stats_total() and
+//    radix_sort_stats_reset(). By default statistics are compiled out,
+//    and these functions return zeroes.
+//
+// TRACING
+//    If RADIXSORT_TRACE is defined to 1 (requires C++11), calls on a thread
+//    that has a radix_sort_trace attached (radix_sort_trace_attach())
+//    record timestamped spans: the exported call, histogram, prefix sum,
+//    scatter or permutation of each pass, and the recursion into buckets
+//    of each MSD level (which includes fallback_sort() of small buckets).
+//    Only calls and buckets of at least RADIXSORT_TRACE_MIN_N elements are
+//    recorded. radix_sort_trace_write() saves traces of one or more threads
+//    as Chrome/Perfetto JSON (load in chrome://tracing or ui.perfetto.dev).
+//
+// ASYNCHRONOUS SORTING
+//    If RADIXSORT_ASYNC is defined to 1 (requires C++11 and threads),
+//    radix_sort_stable_async() and radix_sort_inplace_async() queue the
+//    sort to a persistent library-owned worker pool and return a
+//    std::future (or call a completion callback). The pool size and CPU
+//    affinity are set with radix_sort_pool_configure(). This, coroutine
+//    frames and radix_heap are the only parts of the library that
+//    allocate memory dynamically. Statistics of async sorts are recorded
+//    on the worker threads, so radix_sort_stats_last() and
+//    radix_sort_stats_total() of the submitting thread do not include them.
+//
+// INCREMENTAL SORTING
+//    radix_sort_incremental<T,Traits> is a resumable sort object: after
+//    init() with the same arguments as radix_sort_stable(), each call to
+//    step(elements) or step_for(microseconds) advances the sort within
+//    the given budget and returns true once it is done; progress()
+//    reports the fraction of work done. It uses 8-bit digits and the same
+//    LSD/MSD choice as radix_sort_stable().
+//
+// COROUTINES
+//    With C++20 coroutines available, radix_sort_stable_task() wraps the
+//    sort into a coroutine that suspends after about 'quantum' elements
+//    of work (a histogram, scatter or copy step of that many elements, or
+//    a batch of small MSD buckets). Each resume() continues from there.
+//    It is built on radix_sort_incremental.
+//
+// PLANNING
+//    radix_sort_stable_plan<T,Traits>(n,destination,mode) and
+//    radix_sort_inplace_plan<T,Traits>(n) return, without sorting, the
+//    algorithm and digit width the corresponding function would pick,
+//    expected number of passes, scratch and stack requirements and
+//    expected memory traffic (see radix_sort_plan). Non-template versions
+//    taking element size and key width are also provided.
+//
+// RE-SORTING
+//    radix_sort_resort<T,Traits>(data,tmp,n,changed,m) re-sorts the
+//    output of a previous sort after some elements' keys changed (given
+//    as a list of positions, or as a bitmap): only the changed elements
+//    are radix sorted, and then merged with the rest, which is still in
+//    order. If more than 1/RADIXSORT_RESORT_RATIO of elements changed it
+//    sorts everything with radix_sort_stable() instead.
+//
+// SPATIAL SORTING
+//    radix_sort_spatial<C>(x,y,z,stride,n,bounds,curve,buf,tmp) sorts 2D
+//    or 3D points with float or integer coordinates (SoA or AoS, via
+//    'stride') by their Morton or Hilbert code, computing the codes on
+//    the fly, and returns {code,index} items; radix_sort_spatial_gather()
+//    applies the resulting permutation to the data.
+//
+// APPLYING PERMUTATIONS
+//    radix_sort_permute_inplace() and radix_sort_permute_gather() reorder
+//    several arrays (of any element sizes, see radix_sort_column) by a
+//    permutation, e. g. the index field of sorted {key,index} pairs. The
+//    former follows cycles in place (needs an n-bit scratch bitmap), the
+//    latter gathers one array at a time through a scratch buffer.
+//
+// BUILDING CSR MATRICES
+//    radix_sort_coo_to_csr() builds CSR row offsets, columns and values
+//    from (row,col,val) triples by counting sort on rows, taking row
+//    offsets straight from the row histogram; optionally columns are
+//    ordered within rows and duplicate entries summed.
+//
+// SUFFIX ARRAYS
+//    radix_sort_suffix_array(text,n,sa,scratch) builds the suffix array of
+//    a byte string by prefix doubling, sorting {rank pair,index} records
+//    with stable LSD radix sort in each round.
+//
+// RADIX HEAP
+//    radix_heap<K,V> is a monotone priority queue (popped keys never
+//    decrease) for unsigned integer keys, with amortized O(1) push and
+//    pop, and bulk push() and pop(). It allocates memory (std::vector).
+//
+// SEARCH LAYOUTS
+//    radix_sort_eytzinger() and radix_sort_btree() rearrange sorted output
+//    into Eytzinger or static B-tree (cache line sized nodes) order, which
+//    radix_sort_eytzinger_lower_bound() and radix_sort_btree_lower_bound()
+//    search faster than a sorted array; batch versions of lookups overlap
+//    cache misses of several queries.
+//
+// COMPRESSED OUTPUT
+//    radix_sort_compress() encodes keys of sorted output as blocks of
+//    bit-packed or varint differences with a block index, and
+//    radix_sort_stable_compressed() sorts and encodes in one call;
+//    radix_sort_decompress() and radix_sort_decompress_block() decode.
+//
+// PACKED INPUT
+//    radix_sort_packed() and radix_sort_packed_for() sort columns stored
+//    bit-packed at a fixed width or as frame-of-reference blocks (written
+//    by radix_sort_pack() and radix_sort_pack_for()), decoding them inside
+//    the first LSD pass instead of into a separate array.
+//
+// BUCKETIZING
+//    radix_sort_bucketize() is a stable k-way partition by a user
+//    classifier function, using the count and scatter of a radix pass;
+//    radix_sort_bucketize_inplace() is the unstable inplace version, and
+//    radix_sort_bucketize_parallel() (with RADIXSORT_ASYNC) splits the
+//    work over the worker pool.
+//
+// ROARING BITMAPS
+//    radix_sort_build_roaring() builds a roaring-style compressed bitmap
+//    (array, bitmap and run containers per 64K chunk) from unsorted
+//    32-bit values in one radix pass on their top 16 bits, choosing each
+//    container type from the pass's histogram; radix_sort_roaring_contains()
+//    looks values up.
+
+#include <cstddef> // For size_t.
+#include <cassert> // For assert().
+#include <climits> // For CHAR_BIT.
+#include <cstring> // For memcpy().
+#include <vector>  // For radix_heap buckets.
+#if __cplusplus>=201103L
+#include <chrono>
+#endif
+
+// Simple and hopefully unproblematic prefetching.
+#if defined(__GNUC__) // GCC, clang, or icc.
+static inline void radixsort_prefetch(const void *p)
+{
+    __builtin_prefetch(p,0,3);
+}
+#elif defined(__SSE__) || (defined(_M_IX86_FP) && (_M_IX86_FP>0)) || defined(_M_AMD64) || defined(_M_X64)
+// x86/x64, hopefully compiler understands intrinsics.
+#include <xmmintrin.h>
+static inline void radixsort_prefetch(const void *p)
+{
+    _mm_prefetch((const char*)p,_MM_HINT_T0);
+}
+#else // Short on luck, no-op.
+static inline void radixsort_prefetch(const void *p)
+{
+    (void)p;
+}
+#endif
+
+// This function is here to satisfy the C++ Standard.
+// Merely creating out-of-bounds pointer via address arithmetic is
+// undefined behavior, but creating it via conversion from
+// integer is implementation-defined.
+// The prefetch itself does accept invalid address.
+// If we don't have large enough integer type to hold void*,
+// then we test for out-of-bounds. This does not seem to impact
+// performance much, but removing the test is very unlikely to cause
+// problems in practice, despite being technically UB.
+#if __cplusplus>=201103L // C++11. We have <cstdint>.
+#include <cstdint>
+#ifdef UINTPTR_MAX       // We have uintptr_t.
+static inline void radixsort_lookahead(const void *p,std::size_t delta)
+{
+    (void)delta;
+    radixsort_prefetch((const void*)(std::uintptr_t(p)+16));
+}
+#else
+static inline void radixsort_lookahead(const void *p,std::size_t delta)
+{
+    if(sizeof(std::size_t)>=sizeof(void*)) radixsort_prefetch((const void*)(std::size_t(p)+16));
+    else if(delta<16) radixsort_prefetch((const char*)(p)+16);
+}
+#endif
+#else
+static inline void radixsort_lookahead(const void *p,std::size_t delta)
+{
+    if(sizeof(std::size_t)>=sizeof(void*)) radixsort_prefetch((const void*)(std::size_t(p)+16));
+    else if(delta<16) radixsort_prefetch((const char*)(p)+16);
+}
+#endif
+
+// Statistics.
+
+struct radix_sort_stats
+{
+    unsigned long long calls;          // Calls to exported functions.
+    unsigned long long lsd_calls;      // ...which chose LSD radix sort.
+    unsigned long long msd_calls;      // ...which chose MSD radix sort.
+    unsigned long long inplace_calls;  // ...which were radix_sort_inplace().
+    unsigned long long wide_calls;     // ...which used 11-bit digits.
+    unsigned long long passes;         // Radix passes (histograms computed).
+    unsigned long long passes_skipped; // ...with all keys in the same bucket.
+    unsigned long long bytes_moved;    // Bytes written by scatters and fallback (inplace passes count all n).
+    unsigned long long fallback_calls; // MSD buckets sorted by fallback_sort().
+    unsigned long long max_depth;      // Deepest MSD recursion level.
+};
+
+#ifndef RADIXSORT_STATS
+#define RADIXSORT_STATS 0
+#endif
+
+#if RADIXSORT_STATS
+#if __cplusplus>=201103L
+#define RADIXSORT_THREAD_LOCAL thread_local
+#elif defined(__GNUC__)
+#define RADIXSORT_THREAD_LOCAL __thread
+#else
+#define RADIXSORT_THREAD_LOCAL
+#endif
+static RADIXSORT_THREAD_LOCAL radix_sort_stats radixsort_stats_now,radixsort_stats_last,radixsort_stats_sum;
+#define RADIXSORT_STAT(field,value) (void)(radixsort_stats_now.field+=(value))
+#define RADIXSORT_STAT_MAX(field,value) (void)(radixsort_stats_now.field<(value)?radixsort_stats_now.field=(value):0)
+#else
+#define RADIXSORT_STAT(field,value) (void)0
+#define RADIXSORT_STAT_MAX(field,value) (void)0
+#endif
+
+static inline void radixsort_stats_begin()
+{
+#if RADIXSORT_STATS
+    radix_sort_stats zero={0,0,0,0,0,0,0,0,0,0};
+    radixsort_stats_now=zero;
+    radixsort_stats_now.calls=1;
+#endif
+}
+
+static inline void radixsort_stats_end()
+{
+#if RADIXSORT_STATS
+    radix_sort_stats &s=radixsort_stats_sum;
+    const radix_sort_stats &c=radixsort_stats_now;
+    s.calls+=c.calls;
+    s.lsd_calls+=c.lsd_calls;
+    s.msd_calls+=c.msd_calls;
+    s.inplace_calls+=c.inplace_calls;
+    s.wide_calls+=c.wide_calls;
+    s.passes+=c.passes;
+    s.passes_skipped+=c.passes_skipped;
+    s.bytes_moved+=c.bytes_moved;
+    s.fallback_calls+=c.fallback_calls;
+    if(s.max_depth<c.max_depth) s.max_depth=c.max_depth;
+    radixsort_stats_last=c;
+#endif
+}
+
+// Stats of the last call to an exported function, on this thread.
+inline radix_sort_stats radix_sort_stats_last()
+{
+#if RADIXSORT_STATS
+    return radixsort_stats_last;
+#else
+    radix_sort_stats zero={0,0,0,0,0,0,0,0,0,0};
+    return zero;
+#endif
+}
+
+// Stats summed over all calls on this thread since the last reset
+// (max_depth is the maximum).
+inline radix_sort_stats radix_sort_stats_total()
+{
+#if RADIXSORT_STATS
+    return radixsort_stats_sum;
+#else
+    return radix_sort_stats_last();
+#endif
+}
+
+inline void radix_sort_stats_reset()
+{
+#if RADIXSORT_STATS
+    radix_sort_stats zero={0,0,0,0,0,0,0,0,0,0};
+    radixsort_stats_last=zero;
+    radixsort_stats_sum=zero;
+#endif
+}
+
+// Tracing.
+
+#ifndef RADIXSORT_TRACE
+#define RADIXSORT_TRACE 0
+#endif
+
+#if RADIXSORT_TRACE
+#if __cplusplus<201103L
+#error "RADIXSORT_TRACE requires C++11."
+#endif
+#include <cstdio>
+
+// Number of spans a radix_sort_trace holds. Spans past that are dropped.
+#ifndef RADIXSORT_TRACE_CAPACITY
+#define RADIXSORT_TRACE_CAPACITY 4096
+#endif
+
+// Smaller calls and buckets are not traced, so that a big MSD sort does
+// not record thousands of tiny recursions.
+#ifndef RADIXSORT_TRACE_MIN_N
+#define RADIXSORT_TRACE_MIN_N 65536
+#endif
+
+struct radix_sort_trace_event
+{
+    const char *name;
+    long long begin,end; // Nanoseconds, steady clock.
+    std::size_t n;
+    int shift;           // Digit offset in bits (-1 if not applicable).
+};
+
+struct radix_sort_trace
+{
+    std::size_t count;   // Recorded spans.
+    std::size_t dropped; // Spans lost to overflow.
+    radix_sort_trace_event events[RADIXSORT_TRACE_CAPACITY];
+};
+
+static thread_local radix_sort_trace *radixsort_trace_current=0;
+
+static inline long long radixsort_trace_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Records a span from construction to destruction into the trace attached
+// to this thread, if any.
+class radixsort_trace_span
+{
+public:
+    radixsort_trace_span(const char *name,std::size_t n,int shift):e(0)
+    {
+        radix_sort_trace *t=radixsort_trace_current;
+        if(!t||n<RADIXSORT_TRACE_MIN_N) return;
+        if(t->count==RADIXSORT_TRACE_CAPACITY) {++t->dropped; return;}
+        e=&t->events[t->count++];
+        e->name=name; e->n=n; e->shift=shift;
+        e->begin=e->end=radixsort_trace_now();
+    }
+    ~radixsort_trace_span() {if(e) e->end=radixsort_trace_now();}
+private:
+    radixsort_trace_span(const radixsort_trace_span&);
+    radixsort_trace_span &operator=(const radixsort_trace_span&);
+    radix_sort_trace_event *e;
+};
+#define RADIXSORT_TRACE_SPAN(name,n,shift) radixsort_trace_span radixsort_trace_span_(name,n,int(shift))
+
+// Starts recording spans of calls made on this thread into 'trace'
+// (which should be zero-initialized), or stops if null.
+inline void radix_sort_trace_attach(radix_sort_trace *trace)
+{
+    radixsort_trace_current=trace;
+}
+
+// Writes traces (e. g. one per thread) in Chrome/Perfetto JSON format,
+// thread ids being the indices in 'traces' (plus one).
+inline void radix_sort_trace_write(std::FILE *f,const radix_sort_trace *const *traces,std::size_t count)
+{
+    using std::size_t;
+    long long t0=0;
+    bool first=true;
+    for(size_t i=0;i<count;++i)
+        for(size_t j=0;j<traces[i]->count;++j)
+            if(first||traces[i]->events[j].begin<t0) {t0=traces[i]->events[j].begin; first=false;}
+    std::fprintf(f,"{\"traceEvents\":[");
+    first=true;
+    for(size_t i=0;i<count;++i)
+        for(size_t j=0;j<traces[i]->count;++j)
+        {
+            const radix_sort_trace_event &e=traces[i]->events[j];
+            std::fprintf(f,"%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"n\":%llu,\"shift\":%d}}",
+                first?"":",",e.name,unsigned(i+1),double(e.begin-t0)*1e-3,double(e.end-e.begin)*1e-3,
+                (unsigned long long)e.n,e.shift);
+            first=false;
+        }
+    std::fprintf(f,"\n]}\n");
+}
+#else
+#define RADIXSORT_TRACE_SPAN(name,n,shift) (void)0
+#endif
+
+// Internal functions.
+
+// Fallback sort, used by MSD radix sort on small (~256) inputs.
+// Simple out-of-place merge sort, which further falls back
+// to insertion sort for smaller (~18) inputs.
+template<typename T,typename Traits>
+static inline T *fallback_sort(T *src,T *tmp,std::size_t n,int destination)
+{
+    using std::size_t;
+    T *d=(destination==0?src:tmp);
+    RADIXSORT_STAT(bytes_moved,n*sizeof(T));
+    // 18 is an experimentally chosen threshold.
+    if(n<=18) // Insertion sort.
+    {
+        if(n>0) d[0]=src[0];
+        for(size_t i=1;i<n;++i)
+        {
+            T t=src[i];
+            size_t j=i;
+            for(;j>0&&Traits::get_key(t)<Traits::get_key(d[j-1]);--j) d[j]=d[j-1];
+            d[j]=t;
+        }
+        return d;
+    }
+    size_t a=n/2,b=n-a;
+    fallback_sort<T,Traits>(src,tmp,a,!destination);
+    fallback_sort<T,Traits>(src+a,tmp+a,b,!destination);
+    const T *l=(destination==0?tmp:src);
+    const T *r=l+a;
+    size_t i=0,j=0,k=0;
+    while(true)
+    {
+        if(Traits::get_key(r[j])<Traits::get_key(l[i])) {d[k++]=r[j++]; if(j==b) break;}
+        else                                            {d[k++]=l[i++]; if(i==a) break;}
+    }
+    if(i==a) while(j<b) d[k++]=r[j++];
+    else     while(i<a) d[k++]=l[i++];
+    return d;
+}
+
+// Building blocks of a single radix pass, shared by all the drivers below.
+// Digit of a key is (key>>OFFSET)&MASK.
+
+// Order-independent checksum of keys, used for verification. Sum of
+// (mixed) keys is the same for any permutation of the input.
+template<typename K>
+static inline unsigned long long radixsort_mix(K key)
+{
+    unsigned long long h=(unsigned long long)key*0x9E3779B97F4A7C15ull;
+    return h^(h>>29);
+}
+
+template<typename T,typename Traits>
+static inline void radixsort_checksum(const T *src,std::size_t n,unsigned long long *sum)
+{
+    using std::size_t;
+    unsigned long long s=0;
+    for(size_t i=0;i<n;++i) s+=radixsort_mix(Traits::get_key(src[i]));
+    *sum+=s;
+}
+
+// Histogram of digits. Counts go to c[2*k] and c[2*k+1] (c must be zeroed,
+// 2*(MASK+1) in size). Unrolled x2 to mitigate store->load hit.
+// If 'sum' is not null, checksum of keys is computed along the way.
+template<typename T,std::size_t OFFSET,std::size_t MASK,typename Traits>
+static inline void radixsort_count(const T *src,std::size_t n,std::size_t *c,unsigned long long *sum=0)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("count",n,OFFSET);
+    if(sum)
+    {
+        unsigned long long s0=0,s1=0;
+        for(size_t i=0,m=n/2;i<m;++i)
+        {
+            s0+=radixsort_mix(Traits::get_key(src[2*i  ]));
+            s1+=radixsort_mix(Traits::get_key(src[2*i+1]));
+            size_t k0=size_t(Traits::get_key(src[2*i  ])>>OFFSET)&MASK;
+            size_t k1=size_t(Traits::get_key(src[2*i+1])>>OFFSET)&MASK;
+            ++c[2*k0  ];
+            ++c[2*k1+1];
+        }
+        *sum+=s0+s1;
+        if(n&1) radixsort_checksum<T,Traits>(src+n-1,1,sum);
+    }
+    else
+        for(size_t i=0,m=n/2;i<m;++i)
+        {
+            size_t k0=size_t(Traits::get_key(src[2*i  ])>>OFFSET)&MASK;
+            size_t k1=size_t(Traits::get_key(src[2*i+1])>>OFFSET)&MASK;
+            ++c[2*k0  ];
+            ++c[2*k1+1];
+        }
+    if(n&1) ++c[2*(size_t(Traits::get_key(src[n-1])>>OFFSET)&MASK)];
+}
+
+// Turns the histogram into bucket offsets c[0..SIZE-1] (cumulative
+// distribution function). Returns true if all keys are in the same bucket.
+template<std::size_t SIZE>
+static inline bool radixsort_prefix(std::size_t *c,std::size_t n)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("prefix",n,-1);
+    for(size_t j=0,s=0,t;j<SIZE;++j) {t=s; s+=c[2*j]+c[2*j+1]; c[j]=t;}
+    for(size_t j=0;j+1<SIZE;++j)
+        if(c[j+1]-c[j]==n) return true;
+    return false;
+}
+
+// Stable out-of-place scatter. Advances c[k] to the end of each bucket.
+// 'dst' holds 'total' elements (n, unless src is a part of the input).
+template<typename T,std::size_t OFFSET,std::size_t MASK,bool LOOKAHEAD,typename Traits>
+static inline void radixsort_scatter(const T *src,T *dst,std::size_t n,std::size_t *c,std::size_t total=0)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("scatter",n,OFFSET);
+    if(total==0) total=n;
+    for(size_t i=0;i<n;++i)
+    {
+        size_t k=size_t(Traits::get_key(src[i])>>OFFSET)&MASK;
+        if(LOOKAHEAD) radixsort_lookahead(dst+c[k],(total-c[k])*sizeof(T));
+        dst[c[k]++]=src[i];
+    }
+    RADIXSORT_STAT(bytes_moved,n*sizeof(T));
+}
+
+// Inplace scatter, by walking permutation cycles. Buckets are [c[j],d[j]),
+// on return c[j]==d[j].
+template<typename T,std::size_t OFFSET,std::size_t MASK,typename Traits>
+static inline void radixsort_permute(T *src,std::size_t n,std::size_t *c,const std::size_t *d)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("permute",n,OFFSET);
+    for(size_t j=0;j<=MASK;++j)
+        for(;c[j]!=d[j];++c[j])
+        {
+            size_t k=c[j],h=size_t(Traits::get_key(src[k])>>OFFSET)&MASK;
+            while(j!=h)
+            {
+                T t=src[c[h]];
+                radixsort_lookahead(src+c[h],(n-c[h])*sizeof(T));
+                src[c[h]++]=src[k];
+                src[k]=t;
+                h=size_t(Traits::get_key(t)>>OFFSET)&MASK;
+            }
+        }
+    RADIXSORT_STAT(bytes_moved,n*sizeof(T));
+}
+
+// Bucket directory of the top 'bits' bits of keys of sorted[0..n):
+// dir[b] is the first element whose top bits are at least b, found by
+// binary search within the previous bucket's tail.
+template<typename T,typename Traits>
+static inline void radixsort_directory_search(const T *sorted,std::size_t n,unsigned bits,std::size_t *dir)
+{
+    using std::size_t;
+    const unsigned shift=unsigned(sizeof(Traits::get_key(*sorted))*CHAR_BIT)-bits;
+    const size_t m=size_t(1)<<bits;
+    dir[0]=0;
+    for(size_t b=1;b<m;++b)
+    {
+        size_t lo=dir[b-1],hi=n;
+        while(lo<hi)
+        {
+            size_t mid=lo+(hi-lo)/2;
+            if(size_t(Traits::get_key(sorted[mid])>>shift)<b) lo=mid+1;
+            else hi=mid;
+        }
+        dir[b]=lo;
+    }
+    dir[m]=n;
+}
+
+// Bucket directory of the top 8 bits from offsets c[0..SIZE) of the top
+// digit. A top digit of fewer than 8 bits is too coarse; the callers then
+// search the sorted output with radixsort_directory_search() instead.
+template<std::size_t SIZE>
+static inline void radixsort_directory(const std::size_t *c,std::size_t n,std::size_t *dir)
+{
+    using std::size_t;
+    if(SIZE<256) return;
+    static const size_t STEP=(SIZE<256?1:SIZE/256);
+    for(size_t j=0;j<256;++j) dir[j]=c[j*STEP];
+    dir[256]=n;
+}
+
+// Width of keys of 'Traits' in bits, where MSD recursion starts. Keys of
+// radixsort_top_key (see radix_sort_stable_top()) are B bits wide, in a
+// wider type.
+template<typename T,std::size_t B,typename Traits> struct radixsort_top_key;
+template<typename T,typename Traits> struct radixsort_key_bits {static const std::size_t value=sizeof(Traits::get_key(*(const T*)0))*CHAR_BIT;};
+template<typename T,std::size_t B,typename Traits> struct radixsort_key_bits<T,radixsort_top_key<T,B,Traits> > {static const std::size_t value=B;};
+
+// Sort an array according to its WIDTH lower bits, in radix of (1<<BITS).
+template<typename T,std::size_t WIDTH,std::size_t BITS,std::size_t THRESHOLD,typename Traits>
+static inline T *radix_sort_msd_impl(T *src,T *dst,std::size_t n,int destination,unsigned long long *sum=0,std::size_t *dir=0)
+{
+    using std::size_t;
+    static const size_t LOG2SIZE=(BITS<WIDTH?BITS:WIDTH);
+    static const size_t SIZE=1u<<LOG2SIZE;
+    static const size_t OFFSET=WIDTH-LOG2SIZE;
+    static const size_t MASK=SIZE-1;
+    if(n<THRESHOLD)
+    {
+        RADIXSORT_STAT(fallback_calls,1);
+        if(sum) radixsort_checksum<T,Traits>(src,n,sum);
+        T *ret=fallback_sort<T,Traits>(src,dst,n,destination);
+        if(dir) radixsort_directory_search<T,Traits>(ret,n,8,dir);
+        return ret;
+    }
+    RADIXSORT_STAT_MAX(max_depth,(radixsort_key_bits<T,Traits>::value-WIDTH)/BITS+1);
+    RADIXSORT_STAT(passes,1);
+    size_t c[2*SIZE]={0};
+    radixsort_count<T,OFFSET,MASK,Traits>(src,n,c,sum);
+    bool same=radixsort_prefix<SIZE>(c,n); // All keys are in the same bucket.
+    if(dir) radixsort_directory<SIZE>(c,n,dir);
+    if(same)
+    {
+        RADIXSORT_STAT(passes_skipped,1);
+        T *tmp=src;src=dst;dst=tmp;
+        destination^=1;
+    }
+    else radixsort_scatter<T,OFFSET,MASK,true,Traits>(src,dst,n,c);
+    T *out=(destination==0?src:dst);
+    if(OFFSET>0)
+    {
+        // Recursion into buckets, including fallback_sort() of small ones.
+        RADIXSORT_TRACE_SPAN("buckets",n,OFFSET);
+        for(size_t j=0,b=0;j<SIZE;b=c[j++])
+            switch(c[j]-b)
+            {
+                case 0: break;
+                case 1: out[b]=dst[b]; break;
+                case 2:
+                {
+                    bool flip=(Traits::get_key(dst[b+1])<Traits::get_key(dst[b]));
+                    T L=dst[b+flip],H=dst[b+!flip];
+                    out[b]=L; out[b+1]=H;
+                    break;
+                }
+                default: radix_sort_msd_impl<T,(OFFSET>0?OFFSET:WIDTH),BITS,THRESHOLD,Traits>(dst+b,src+b,c[j]-b,destination^1);
+            }
+    }
+    if(OFFSET==0&&destination==0)
+    {
+        for(size_t i=0;i<n;++i) src[i]=dst[i];
+        RADIXSORT_STAT(bytes_moved,n*sizeof(T));
+    }
+    if(dir&&SIZE<256) radixsort_directory_search<T,Traits>(out,n,8,dir);
+    return out;
+}
+
+// Sort an array according to its WIDTH upper bits, in radix of (1<<BITS).
+template<typename T,std::size_t WIDTH,std::size_t BITS,typename Traits>
+static inline T *radix_sort_lsd_impl(T *src,T *dst,std::size_t n,unsigned long long *sum=0,std::size_t *dir=0)
+{
+    using std::size_t;
+    static const size_t OFFSET=sizeof(Traits::get_key(*src))*CHAR_BIT-WIDTH;
+    static const size_t SIZE=1u<<(BITS<WIDTH?BITS:WIDTH);
+    static const size_t MASK=SIZE-1;
+    RADIXSORT_STAT(passes,1);
+    size_t c[2*SIZE]={0};
+    radixsort_count<T,OFFSET,MASK,Traits>(src,n,c,sum);
+    bool same=radixsort_prefix<SIZE>(c,n); // All keys are in the same bucket.
+    if(dir&&BITS>=WIDTH) radixsort_directory<SIZE>(c,n,dir); // Top digit.
+    if(same)
+    {
+        RADIXSORT_STAT(passes_skipped,1);
+        T *tmp=src;src=dst;dst=tmp;
+    }
+    else radixsort_scatter<T,OFFSET,MASK,true,Traits>(src,dst,n,c);
+    // Conditionals are to stop template expansion recursion.
+    if(BITS<WIDTH) return radix_sort_lsd_impl<T,(BITS<WIDTH?WIDTH-BITS:WIDTH),BITS,Traits>(dst,src,n,0,dir);
+    if(dir&&SIZE<256) radixsort_directory_search<T,Traits>(dst,n,8,dir);
+    return dst;
+}
+
+// Sort an array according to its WIDTH lower bits, in radix of (1<<BITS).
+template<typename T,std::size_t WIDTH,std::size_t BITS,std::size_t THRESHOLD,typename Traits>
+static inline void radix_sort_msd_inplace_impl(T *src,std::size_t n,unsigned long long *sum=0,std::size_t *dir=0)
+{
+    using std::size_t;
+    static const size_t LOG2SIZE=(BITS<WIDTH?BITS:WIDTH);
+    static const size_t SIZE=1u<<LOG2SIZE;
+    static const size_t OFFSET=WIDTH-LOG2SIZE;
+    static const size_t MASK=SIZE-1;
+    if(n<THRESHOLD)
+    {
+        RADIXSORT_STAT(fallback_calls,1);
+        if(sum) radixsort_checksum<T,Traits>(src,n,sum);
+        T tmp[THRESHOLD];
+        fallback_sort<T,Traits>(src,tmp,n,0);
+        if(dir) radixsort_directory_search<T,Traits>(src,n,8,dir);
+        return;
+    }
+    RADIXSORT_STAT_MAX(max_depth,(radixsort_key_bits<T,Traits>::value-WIDTH)/BITS+1);
+    RADIXSORT_STAT(passes,1);
+    size_t c[2*SIZE]={0},*d=c+SIZE;
+    radixsort_count<T,OFFSET,MASK,Traits>(src,n,c,sum);
+    bool same=radixsort_prefix<SIZE>(c,n); // All keys are in the same bucket.
+    if(same) RADIXSORT_STAT(passes_skipped,1);
+    if(dir) radixsort_directory<SIZE>(c,n,dir);
+    for(size_t j=0;j+1<SIZE;++j) d[j]=c[j+1];
+    d[SIZE-1]=n;
+    if(!same) radixsort_permute<T,OFFSET,MASK,Traits>(src,n,c,d);
+    if(OFFSET>0)
+    {
+        RADIXSORT_TRACE_SPAN("buckets",n,OFFSET);
+        for(size_t j=0,b=0;j<SIZE;b=d[j++])
+            switch(d[j]-b)
+            {
+                case 0:
+                case 1: break;
+                case 2: if(Traits::get_key(src[b+1])<Traits::get_key(src[b])) {T tmp=src[b+1];src[b+1]=src[b];src[b]=tmp;} break;
+                default: radix_sort_msd_inplace_impl<T,(OFFSET>0?OFFSET:WIDTH),BITS,THRESHOLD,Traits>(src+b,d[j]-b); break;
+            }
+    }
+    if(dir&&SIZE<256) radixsort_directory_search<T,Traits>(src,n,8,dir);
+}
+
+// MSD and LSD out-of-place versions of radix sort.
+// Used internally by radix_sort_stable(), but are usable as is, with
+// somewhat decent performance.
+
+template<typename T,std::size_t BITS,std::size_t THRESHOLD,typename Traits>
+static inline T *radix_sort_msd(T *src,T *tmp,std::size_t n,int destination,unsigned long long *sum=0,std::size_t *dir=0)
+{
+    if(destination!=1) destination=0;
+    return radix_sort_msd_impl<T,sizeof(Traits::get_key(*src))*CHAR_BIT,BITS,THRESHOLD,Traits>(src,tmp,n,destination,sum,dir);
+}
+
+template<typename T,std::size_t BITS,typename Traits>
+static inline T *radix_sort_lsd(T *src,T *tmp,std::size_t n,int destination,unsigned long long *sum=0,std::size_t *dir=0)
+{
+    using std::size_t;
+    T *ret=radix_sort_lsd_impl<T,sizeof(Traits::get_key(*src))*CHAR_BIT,BITS,Traits>(src,tmp,n,sum,dir);
+    if(destination==0&&ret!=src) {ret=src; for(size_t i=0;i<n;++i) src[i]=tmp[i]; RADIXSORT_STAT(bytes_moved,n*sizeof(T));}
+    if(destination==1&&ret!=tmp) {ret=tmp; for(size_t i=0;i<n;++i) tmp[i]=src[i]; RADIXSORT_STAT(bytes_moved,n*sizeof(T));}
+    return ret;
+}
+
+// Dispatch heuristics, shared by the exported functions and the planner.
+
+// Generally, MSD is faster for:
+//   * small inputs
+//   * large keys
+//   * large data on large inputs
+// Also user may have explicitly asked for it.
+// 1500 and 1000000 are experimentally chosen thresholds.
+static inline bool radixsort_use_msd(std::size_t n,std::size_t elem_size,std::size_t key_bits,int mode)
+{
+    return mode!=0&&(
+        mode==1||n<1500||
+        key_bits>40||
+        (elem_size*CHAR_BIT>64&&n>10000000ul/elem_size));
+}
+
+// Digit width for MSD radix sort.
+static inline unsigned radixsort_msd_bits(std::size_t n)
+{
+    unsigned bits=8;
+    // Some experimantally chosen ranges.
+    if(n>4000u&&n<60000u) bits=11;
+    if(n>2000000ul&&n<9000000ul) bits=11;
+    return bits;
+}
+
+// Checks that output is ordered and that its keys checksum to 'sum'.
+// Branch-free, so that compilers may vectorize it.
+template<typename T,typename Traits>
+static inline bool radixsort_verify(const T *out,std::size_t n,unsigned long long sum)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("verify",n,-1);
+    unsigned long long s=0;
+    unsigned bad=0;
+    if(n>0) s=radixsort_mix(Traits::get_key(out[0]));
+    for(size_t i=1;i<n;++i)
+    {
+        bad|=unsigned(Traits::get_key(out[i])<Traits::get_key(out[i-1]));
+        s+=radixsort_mix(Traits::get_key(out[i]));
+    }
+    return !bad&&s==sum;
+}
+
+template<typename T,typename Traits>
+static inline T *radixsort_stable(T *src,T* tmp,std::size_t n,int destination,int mode,unsigned long long *sum,std::size_t *dir=0)
+{
+    if(radixsort_use_msd(n,sizeof(T),sizeof(Traits::get_key(*src))*CHAR_BIT,mode))
+    {
+        unsigned bits=radixsort_msd_bits(n);
+        radixsort_stats_begin();
+        RADIXSORT_STAT(msd_calls,1);
+        RADIXSORT_STAT(wide_calls,bits==11);
+        T *ret;
+        if(bits==8) ret=radix_sort_msd<T, 8,128,Traits>(src,tmp,n,destination,sum,dir);
+        else        ret=radix_sort_msd<T,11,256,Traits>(src,tmp,n,destination,sum,dir);
+        radixsort_stats_end();
+        return ret;
+    }
+
+    // Otherwise, return LSD.
+    radixsort_stats_begin();
+    RADIXSORT_STAT(lsd_calls,1);
+    T *ret=radix_sort_lsd<T,8,Traits>(src,tmp,n,destination,sum,dir);
+    radixsort_stats_end();
+    return ret;
+}
+
+template<typename T,typename Traits>
+static inline void radixsort_inplace(T *src,std::size_t n,unsigned long long *sum,std::size_t *dir=0)
+{
+    unsigned bits=radixsort_msd_bits(n);
+    radixsort_stats_begin();
+    RADIXSORT_STAT(inplace_calls,1);
+    RADIXSORT_STAT(wide_calls,bits==11);
+    if(bits==8) radix_sort_msd_inplace_impl<T,sizeof(Traits::get_key(*src))*CHAR_BIT, 8,128,Traits>(src,n,sum,dir);
+    else        radix_sort_msd_inplace_impl<T,sizeof(Traits::get_key(*src))*CHAR_BIT,11,256,Traits>(src,n,sum,dir);
+    radixsort_stats_end();
+}
+
+// Exported (API) functions.
+
+template<typename T,typename Traits>
+inline T *radix_sort_stable(T *src,T* tmp,std::size_t n,int destination,int mode)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_stable",n,-1);
+    return radixsort_stable<T,Traits>(src,tmp,n,destination,mode,0);
+}
+
+template<typename T,typename Traits>
+inline void radix_sort_inplace(T *src,std::size_t n)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_inplace",n,-1);
+    radixsort_inplace<T,Traits>(src,n,0);
+}
+
+// Same as above, but also check the result: output must be ordered, and
+// its keys must be a permutation of the input's (checked via checksum
+// computed during the first histogram pass). Return null (false) if not.
+
+template<typename T,typename Traits>
+inline T *radix_sort_stable_verified(T *src,T* tmp,std::size_t n,int destination,int mode)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_stable_verified",n,-1);
+    unsigned long long sum=0;
+    T *ret=radixsort_stable<T,Traits>(src,tmp,n,destination,mode,&sum);
+    return radixsort_verify<T,Traits>(ret,n,sum)?ret:0;
+}
+
+template<typename T,typename Traits>
+inline bool radix_sort_inplace_verified(T *src,std::size_t n)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_inplace_verified",n,-1);
+    unsigned long long sum=0;
+    radixsort_inplace<T,Traits>(src,n,&sum);
+    return radixsort_verify<T,Traits>(src,n,sum);
+}
+
+// Precision-limited sorting.
+//
+// radix_sort_stable_top() and radix_sort_inplace_top() order elements by
+// the top B bits of the key only (elements that differ only in lower bits
+// are ties), which is often enough for depth sorting, LOD bucketing or
+// other approximate ordering, and takes fewer passes. LSD runs over just
+// those bits, in ceil(B/8) passes of equal-sized digits. MSD sorts by
+// the key shifted down to its top B bits, so recursion stops once they
+// are exhausted, and fallback_sort() compares the shifted keys, too.
+
+// Unsigned integer type of the given size.
+template<std::size_t SIZE> struct radixsort_uint;
+template<> struct radixsort_uint<1> {typedef unsigned char type;};
+template<> struct radixsort_uint<2> {typedef unsigned short type;};
+template<> struct radixsort_uint<4> {typedef unsigned int type;};
+template<> struct radixsort_uint<8> {typedef unsigned long long type;};
+
+// Traits, whose key is the top B bits of the key of 'Traits'.
+template<typename T,std::size_t B,typename Traits>
+struct radixsort_top_key
+{
+    typedef typename radixsort_uint<sizeof(Traits::get_key(*(const T*)0))>::type key_type;
+    static inline key_type get_key(const T &src)
+    {
+        return key_type(Traits::get_key(src)>>(sizeof(key_type)*CHAR_BIT-B));
+    }
+};
+
+// Sorts (stably) by the top B bits of the key (0<B<=key width); arguments
+// and return value are the same as for radix_sort_stable().
+template<typename T,std::size_t B,typename Traits>
+inline T *radix_sort_stable_top(T *src,T* tmp,std::size_t n,int destination,int mode)
+{
+    using std::size_t;
+    typedef radixsort_top_key<T,B,Traits> Top;
+    RADIXSORT_TRACE_SPAN("radix_sort_stable_top",n,-1);
+    T *ret;
+    if(radixsort_use_msd(n,sizeof(T),B,mode))
+    {
+        unsigned bits=radixsort_msd_bits(n);
+        radixsort_stats_begin();
+        RADIXSORT_STAT(msd_calls,1);
+        RADIXSORT_STAT(wide_calls,bits==11);
+        if(destination!=1) destination=0;
+        if(bits==8) ret=radix_sort_msd_impl<T,B, 8,128,Top>(src,tmp,n,destination);
+        else        ret=radix_sort_msd_impl<T,B,11,256,Top>(src,tmp,n,destination);
+        radixsort_stats_end();
+        return ret;
+    }
+    static const size_t PASSES=(B+7)/8;
+    radixsort_stats_begin();
+    RADIXSORT_STAT(lsd_calls,1);
+    ret=radix_sort_lsd_impl<T,B,(B+PASSES-1)/PASSES,Traits>(src,tmp,n);
+    if(destination==0&&ret!=src) {ret=src; for(size_t i=0;i<n;++i) src[i]=tmp[i]; RADIXSORT_STAT(bytes_moved,n*sizeof(T));}
+    if(destination==1&&ret!=tmp) {ret=tmp; for(size_t i=0;i<n;++i) tmp[i]=src[i]; RADIXSORT_STAT(bytes_moved,n*sizeof(T));}
+    radixsort_stats_end();
+    return ret;
+}
+
+// Same as radix_sort_inplace(), but sorts by the top B bits of the key.
+template<typename T,std::size_t B,typename Traits>
+inline void radix_sort_inplace_top(T *src,std::size_t n)
+{
+    typedef radixsort_top_key<T,B,Traits> Top;
+    RADIXSORT_TRACE_SPAN("radix_sort_inplace_top",n,-1);
+    unsigned bits=radixsort_msd_bits(n);
+    radixsort_stats_begin();
+    RADIXSORT_STAT(inplace_calls,1);
+    RADIXSORT_STAT(wide_calls,bits==11);
+    if(bits==8) radix_sort_msd_inplace_impl<T,B, 8,128,Top>(src,n);
+    else        radix_sort_msd_inplace_impl<T,B,11,256,Top>(src,n);
+    radixsort_stats_end();
+}
+
+// Bucket directories.
+//
+// A bucket directory of B bits is an array of 2^B+1 offsets into sorted
+// output: elements whose keys have top B bits equal to b are
+// [dir[b],dir[b+1]). radix_sort_stable_directory() and
+// radix_sort_inplace_directory() fill one with B=8 (257 offsets) as a
+// by-product of the sort, from the histogram of the top digit, at no
+// extra pass. radix_sort_directory() builds one with any B for data that
+// is already sorted, by 2^B binary searches. Lookups then only search
+// within one bucket.
+
+template<typename T,typename Traits>
+inline T *radix_sort_stable_directory(T *src,T* tmp,std::size_t n,int destination,int mode,std::size_t *dir)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_stable_directory",n,-1);
+    return radixsort_stable<T,Traits>(src,tmp,n,destination,mode,0,dir);
+}
+
+template<typename T,typename Traits>
+inline void radix_sort_inplace_directory(T *src,std::size_t n,std::size_t *dir)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_inplace_directory",n,-1);
+    radixsort_inplace<T,Traits>(src,n,0,dir);
+}
+
+template<typename T,typename Traits>
+inline void radix_sort_directory(const T *sorted,std::size_t n,unsigned bits,std::size_t *dir)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_directory",n,-1);
+    radixsort_directory_search<T,Traits>(sorted,n,bits,dir);
+}
+
+// Index of the first element of 'sorted' (with B-bit directory 'dir')
+// whose key is not less (if UPPER is false) or greater (if UPPER is true)
+// than 'key', or n if there is none. 'key' has the same type as keys.
+template<typename T,typename Traits,bool UPPER,typename K>
+static inline std::size_t radixsort_directory_bound(const T *sorted,const std::size_t *dir,unsigned bits,K key)
+{
+    using std::size_t;
+    const unsigned shift=unsigned(sizeof(Traits::get_key(*sorted))*CHAR_BIT)-bits;
+    size_t b=(bits?size_t(key>>shift):0),lo=dir[b],hi=dir[b+1]; // A 0-bit directory is one bucket.
+    while(lo<hi)
+    {
+        size_t mid=lo+(hi-lo)/2;
+        if(UPPER?!(key<Traits::get_key(sorted[mid])):Traits::get_key(sorted[mid])<key) lo=mid+1;
+        else hi=mid;
+    }
+    return lo;
+}
+
+template<typename T,typename Traits,typename K>
+inline std::size_t radix_sort_directory_lower_bound(const T *sorted,const std::size_t *dir,unsigned bits,K key)
+{
+    return radixsort_directory_bound<T,Traits,false>(sorted,dir,bits,key);
+}
+
+template<typename T,typename Traits,typename K>
+inline std::size_t radix_sort_directory_upper_bound(const T *sorted,const std::size_t *dir,unsigned bits,K key)
+{
+    return radixsort_directory_bound<T,Traits,true>(sorted,dir,bits,key);
+}
+
+// Elements with keys in [lo,hi] are [*first,*last).
+template<typename T,typename Traits,typename K>
+inline void radix_sort_directory_range(const T *sorted,const std::size_t *dir,unsigned bits,K lo,K hi,std::size_t *first,std::size_t *last)
+{
+    *first=radixsort_directory_bound<T,Traits,false>(sorted,dir,bits,lo);
+    *last=radixsort_directory_bound<T,Traits,true>(sorted,dir,bits,hi);
+    if(*last<*first) *last=*first;
+}
+
+// Planning.
+//
+// The radix_sort_plan_*() functions do not sort anything; they report what
+// the corresponding exported function would do for the given input size,
+// element size and key width, so that buffers can be sized and costs
+// compared before sorting. Estimates assume uniformly distributed keys.
+
+struct radix_sort_plan
+{
+    int algorithm;             // 0 - LSD, 1 - MSD, 2 - inplace MSD.
+    int digit_bits;            // Radix is (1<<digit_bits).
+    int passes;                // Expected radix passes (MSD recursion levels).
+    int fallback_levels;       // Expected merge levels of fallback_sort().
+    std::size_t scratch_bytes; // Size of 'tmp' the caller has to supply.
+    std::size_t stack_bytes;   // Upper bound on stack usage.
+    double traffic_bytes;      // Expected bytes read plus bytes written.
+};
+
+// Expected number of levels of fallback_sort() on m elements
+// (insertion sort of the leaves counts as one).
+static inline int radixsort_fallback_levels(double m)
+{
+    int levels=1;
+    for(;m>18.0;m/=2.0) ++levels;
+    return levels;
+}
+
+// Each radix pass reads the data twice (histogram and scatter) and writes
+// it once. MSD recursion stops once buckets drop below the threshold, after
+// which fallback_sort() reads and writes the data once per level.
+static inline radix_sort_plan radixsort_plan_msd(std::size_t n,std::size_t elem_size,std::size_t key_bits,int inplace)
+{
+    using std::size_t;
+    radix_sort_plan ret;
+    size_t bits=radixsort_msd_bits(n),threshold=(bits==8?128:256);
+    size_t table=2*(size_t(1)<<bits)*sizeof(size_t);
+    double m=double(n);
+    ret.algorithm=(inplace?2:1);
+    ret.digit_bits=int(bits);
+    ret.passes=0;
+    for(size_t w=0;w<key_bits&&m>=double(threshold);w+=bits,m/=double(size_t(1)<<bits)) ++ret.passes;
+    ret.fallback_levels=radixsort_fallback_levels(m<double(threshold)?m:double(threshold));
+    ret.scratch_bytes=(inplace?0:n*elem_size);
+    ret.stack_bytes=(key_bits+bits-1)/bits*table+(inplace?threshold*elem_size:0);
+    ret.traffic_bytes=double(n)*double(elem_size)*(3.0*ret.passes+2.0*ret.fallback_levels);
+    return ret;
+}
+
+inline radix_sort_plan radix_sort_plan_stable(std::size_t n,std::size_t elem_size,std::size_t key_bits,int destination,int mode)
+{
+    using std::size_t;
+    if(radixsort_use_msd(n,elem_size,key_bits,mode)) return radixsort_plan_msd(n,elem_size,key_bits,0);
+    static const size_t BITS=8;
+    radix_sort_plan ret;
+    ret.algorithm=0;
+    ret.digit_bits=int(BITS);
+    ret.passes=int((key_bits+BITS-1)/BITS);
+    ret.fallback_levels=0;
+    ret.scratch_bytes=n*elem_size;
+    ret.stack_bytes=size_t(ret.passes)*2*(size_t(1)<<BITS)*sizeof(size_t);
+    ret.traffic_bytes=3.0*ret.passes*double(n)*double(elem_size);
+    // Copy to the requested destination, if the output ended up elsewhere.
+    if((destination==0&&ret.passes%2)||(destination==1&&ret.passes%2==0))
+        ret.traffic_bytes+=2.0*double(n)*double(elem_size);
+    return ret;
+}
+
+inline radix_sort_plan radix_sort_plan_inplace(std::size_t n,std::size_t elem_size,std::size_t key_bits)
+{
+    return radixsort_plan_msd(n,elem_size,key_bits,1);
+}
+
+template<typename T,typename Traits>
+inline radix_sort_plan radix_sort_stable_plan(std::size_t n,int destination,int mode)
+{
+    return radix_sort_plan_stable(n,sizeof(T),sizeof(Traits::get_key(*(T*)0))*CHAR_BIT,destination,mode);
+}
+
+template<typename T,typename Traits>
+inline radix_sort_plan radix_sort_inplace_plan(std::size_t n)
+{
+    return radix_sort_plan_inplace(n,sizeof(T),sizeof(Traits::get_key(*(T*)0))*CHAR_BIT);
+}
+
+// Asynchronous sorting.
+//
+// Sorts are queued (FIFO) to a persistent pool of worker threads owned by
+// the library. Every sort runs on a single worker, so with at most one
+// worker per core concurrent sorts never oversubscribe it; queued sorts
+// wait their turn. An idle worker spins briefly before going to sleep, so
+// that back-to-back jobs do not pay for a wakeup.
+
+#ifndef RADIXSORT_ASYNC
+#define RADIXSORT_ASYNC 0
+#endif
+
+#if RADIXSORT_ASYNC
+#if __cplusplus<201103L
+#error "RADIXSORT_ASYNC requires C++11."
+#endif
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Number of polls of the queue before an idle worker sleeps.
+#ifndef RADIXSORT_POOL_SPIN
+#define RADIXSORT_POOL_SPIN 4000
+#endif
+
+class radix_sort_pool
+{
+public:
+    radix_sort_pool():stop(false),pending(0),nworkers(0) {start(0,0,0);}
+    ~radix_sort_pool() {shutdown();}
+
+    // Restarts the pool with 'threads' workers (0 means one per hardware
+    // thread). If 'cpus' is given, worker i is pinned to cpus[i%ncpus]
+    // (Linux only; ignored elsewhere). Queued jobs are finished first, so
+    // it blocks until they are; it must not be called from a pool job.
+    // Concurrent calls are serialized; jobs submitted meanwhile run on the
+    // new workers.
+    void configure(std::size_t threads,const int *cpus,std::size_t ncpus)
+    {
+        std::lock_guard<std::mutex> lock(config);
+        shutdown();
+        start(threads,cpus,ncpus);
+    }
+
+    std::size_t size() const {return nworkers.load(std::memory_order_acquire);}
+
+    void submit(const std::function<void()> &job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(job);
+            ++pending;
+        }
+        wake.notify_one();
+    }
+
+private:
+    void start(std::size_t threads,const int *cpus,std::size_t ncpus)
+    {
+        if(threads==0) threads=std::thread::hardware_concurrency();
+        if(threads==0) threads=1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop=false;
+        }
+        for(std::size_t i=0;i<threads;++i)
+        {
+            workers.push_back(std::thread(&radix_sort_pool::work,this));
+#if defined(__linux__)
+            if(cpus&&ncpus)
+            {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[i%ncpus],&set);
+                pthread_setaffinity_np(workers.back().native_handle(),sizeof(set),&set);
+            }
+#else
+            (void)cpus; (void)ncpus;
+#endif
+        }
+        nworkers.store(threads,std::memory_order_release);
+    }
+
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop=true;
+        }
+        wake.notify_all();
+        for(std::size_t i=0;i<workers.size();++i) workers[i].join();
+        workers.clear();
+        nworkers.store(0,std::memory_order_release);
+    }
+
+    void work()
+    {
+        for(;;)
+        {
+            for(int i=0;i<RADIXSORT_POOL_SPIN&&pending.load(std::memory_order_relaxed)==0;++i)
+                std::this_thread::yield();
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while(!stop&&jobs.empty()) wake.wait(lock);
+                if(jobs.empty()) return; // Stopped, and nothing left to do.
+                job.swap(jobs.front());
+                jobs.pop_front();
+                --pending;
+            }
+            job();
+        }
+    }
+
+    radix_sort_pool(const radix_sort_pool&);
+    radix_sort_pool &operator=(const radix_sort_pool&);
+
+    std::vector<std::thread> workers; // Changed only under 'config'.
+    std::deque<std::function<void()> > jobs;
+    std::mutex mutex,config;
+    std::condition_variable wake;
+    bool stop;
+    std::atomic<std::size_t> pending,nworkers;
+};
+
+// The library-owned pool, started on first use.
+inline radix_sort_pool &radix_sort_default_pool()
+{
+    static radix_sort_pool pool;
+    return pool;
+}
+
+inline void radix_sort_pool_configure(std::size_t threads,const int *cpus,std::size_t ncpus)
+{
+    radix_sort_default_pool().configure(threads,cpus,ncpus);
+}
+
+// Same as radix_sort_stable(), but runs on the pool. Buffers must stay
+// valid until the future is ready.
+template<typename T,typename Traits>
+inline std::future<T*> radix_sort_stable_async(T *src,T* tmp,std::size_t n,int destination,int mode)
+{
+    std::shared_ptr<std::packaged_task<T*()> > task=std::make_shared<std::packaged_task<T*()> >(
+        [=]() {return radix_sort_stable<T,Traits>(src,tmp,n,destination,mode);});
+    std::future<T*> ret=task->get_future();
+    radix_sort_default_pool().submit([task]() {(*task)();});
+    return ret;
+}
+
+// Completion callback version; 'done' is called on a worker thread.
+template<typename T,typename Traits>
+inline void radix_sort_stable_async(T *src,T* tmp,std::size_t n,int destination,int mode,void (*done)(T *result,void *user),void *user)
+{
+    radix_sort_default_pool().submit(
+        [=]() {done(radix_sort_stable<T,Traits>(src,tmp,n,destination,mode),user);});
+}
+
+template<typename T,typename Traits>
+inline std::future<void> radix_sort_inplace_async(T *src,std::size_t n)
+{
+    std::shared_ptr<std::packaged_task<void()> > task=std::make_shared<std::packaged_task<void()> >(
+        [=]() {radix_sort_inplace<T,Traits>(src,n);});
+    std::future<void> ret=task->get_future();
+    radix_sort_default_pool().submit([task]() {(*task)();});
+    return ret;
+}
+#endif
+
+// Resumable sorting.
+//
+// radix_sort_incremental does the same work as radix_sort_stable(), with
+// 8-bit digits, but as an explicit state machine instead of recursion, so
+// it can stop after roughly a given amount of work (or time) and continue
+// on the next call, e. g. to spread a huge sort over several frames.
+// The recursive drivers cannot be paused mid-pass, so the state machine
+// walks the same passes itself, but each slice of a pass runs the shared
+// radixsort_count(), radixsort_prefix() and radixsort_scatter() (digit
+// offsets are runtime values here, dispatched to their instantiations),
+// and algorithm choice is radixsort_use_msd(). MSD buckets are kept on an
+// explicit stack (at most 256 per digit; 11-bit digits would need 2048),
+// which lives in the object, so the object itself is big (tens of KB); it
+// does not allocate anything. Each step() records its own statistics.
+// Usage:
+//   radix_sort_incremental<KeyValue,GetKey> s;
+//   s.init(src,tmp,n,-1,-1);
+//   // Each frame:
+//   if(s.step_for(2000)) use(s.result()); // 2ms budget.
+//   else show(s.progress());
+
+template<typename T,typename Traits>
+class radix_sort_incremental
+{
+public:
+    void init(T *src,T *tmp,std::size_t n,int destination,int mode)
+    {
+        buf[0]=src; buf[1]=tmp;
+        size=n;
+        msd=radixsort_use_msd(n,sizeof(T),KEYBITS,mode);
+        dest=(msd?(destination==1?1:0):(destination==0||destination==1?destination:-1));
+        top=0; work=0; out=0;
+        node root={0,n,unsigned(msd?KEYBITS-BITS:0),0};
+        if(n<2) {phase=DONE; if(dest==1&&n) tmp[0]=src[0]; out=(dest==1?1:0); return;}
+        start(root);
+    }
+
+    // Does 'quantum' elements worth of work (one element counted,
+    // scattered, copied or sorted in a leaf is a unit; leaves of fewer than
+    // 128 elements are not split, so a step may overshoot by less than
+    // that). Returns true when sorting is done.
+    bool step(std::size_t quantum)
+    {
+        using std::size_t;
+        radixsort_stats_begin();
+        if(work==0) {RADIXSORT_STAT(msd_calls,msd); RADIXSORT_STAT(lsd_calls,!msd);}
+        size_t budget=quantum;
+        while(phase!=DONE&&budget>0)
+        {
+            if(phase==LEAVES) {leaves(budget); continue;}
+            size_t k=cur.n-pos;
+            if(k>budget) k=budget;
+            T *s=buf[cur.in]+cur.begin,*d=buf[!cur.in]+cur.begin;
+            budget-=k;
+            work+=k;
+            if(phase==COUNT)
+            {
+                count(s+pos,k);
+                pos+=k;
+                if(pos==cur.n)
+                {
+                    pos=0;
+                    RADIXSORT_STAT(passes,1);
+                    if(radixsort_prefix<SIZE>(c,cur.n)) // All keys are in the same bucket.
+                    {
+                        RADIXSORT_STAT(passes_skipped,1);
+                        done_node(cur.in);
+                        continue;
+                    }
+                    for(size_t j=0;j<SIZE;++j) b[j]=c[j];
+                    phase=SCATTER;
+                }
+            }
+            else if(phase==SCATTER)
+            {
+                scatter(s+pos,d,k);
+                pos+=k;
+                if(pos==cur.n) {pos=0; done_node(!cur.in);}
+            }
+            else // COPY
+            {
+                for(size_t i=pos;i<pos+k;++i) d[i]=s[i];
+                RADIXSORT_STAT(bytes_moved,k*sizeof(T));
+                pos+=k;
+                if(pos==cur.n) {pos=0; out=!cur.in; next();}
+            }
+        }
+        radixsort_stats_end();
+        return phase==DONE;
+    }
+
+#if __cplusplus>=201103L
+    // Same as step(), but runs until 'microseconds' elapse, checking the
+    // clock every 'quantum' elements of work.
+    bool step_for(unsigned long long microseconds,std::size_t quantum=16384)
+    {
+        typedef std::chrono::steady_clock clock;
+        clock::time_point end=clock::now()+std::chrono::microseconds(microseconds);
+        while(!step(quantum))
+            if(clock::now()>=end) return false;
+        return true;
+    }
+#endif
+
+    bool done() const {return phase==DONE;}
+    // Fraction of work done, from 0 to 1.
+    double progress() const
+    {
+        return phase==DONE?1.0:double(work)/double(total_work());
+    }
+    T *result() const {return phase==DONE?buf[out]:0;}
+    // Units of work done so far.
+    std::size_t done_work() const {return work;}
+    // Expected total units of work (exact for LSD, estimate for MSD).
+    std::size_t total_work() const
+    {
+        using std::size_t;
+        size_t passes=0,ret;
+        if(!msd) passes=(KEYBITS+BITS-1)/BITS;
+        else for(double m=double(size);passes*BITS<KEYBITS&&m>=double(THRESHOLD);m/=double(SIZE)) ++passes;
+        // Histogram and scatter per pass, plus either leaves or final copy.
+        ret=2*size*passes;
+        if(msd||(dest>=0&&passes%2!=unsigned(dest))) ret+=size;
+        return ret>work?ret:work;
+    }
+
+private:
+    static const std::size_t KEYBITS=sizeof(Traits::get_key(*(T*)0))*CHAR_BIT;
+    static const std::size_t BITS=8;
+    static const std::size_t SIZE=1u<<BITS;
+    static const std::size_t MASK=SIZE-1;
+    static const std::size_t THRESHOLD=128;
+    enum {COUNT,SCATTER,COPY,LEAVES,DONE};
+
+    // Offset of digit I (clamped, so that digits past short keys compile).
+    template<std::size_t I> struct digit_offset {static const std::size_t value=(I*BITS<KEYBITS?I*BITS:0);};
+
+    struct node
+    {
+        std::size_t begin,n;
+        unsigned shift;  // Offset of the digit, in bits.
+        unsigned in;     // Which buffer the data is in.
+    };
+
+    // Slices of the current pass.
+    void count(const T *s,std::size_t k)
+    {
+        switch(cur.shift/BITS)
+        {
+            case 0:  radixsort_count<T,digit_offset<0>::value,MASK,Traits>(s,k,c); break;
+            case 1:  radixsort_count<T,digit_offset<1>::value,MASK,Traits>(s,k,c); break;
+            case 2:  radixsort_count<T,digit_offset<2>::value,MASK,Traits>(s,k,c); break;
+            case 3:  radixsort_count<T,digit_offset<3>::value,MASK,Traits>(s,k,c); break;
+            case 4:  radixsort_count<T,digit_offset<4>::value,MASK,Traits>(s,k,c); break;
+            case 5:  radixsort_count<T,digit_offset<5>::value,MASK,Traits>(s,k,c); break;
+            case 6:  radixsort_count<T,digit_offset<6>::value,MASK,Traits>(s,k,c); break;
+            default: radixsort_count<T,digit_offset<7>::value,MASK,Traits>(s,k,c); break;
+        }
+    }
+
+    void scatter(const T *s,T *d,std::size_t k)
+    {
+        switch(cur.shift/BITS)
+        {
+            case 0:  radixsort_scatter<T,digit_offset<0>::value,MASK,true,Traits>(s,d,k,c,cur.n); break;
+            case 1:  radixsort_scatter<T,digit_offset<1>::value,MASK,true,Traits>(s,d,k,c,cur.n); break;
+            case 2:  radixsort_scatter<T,digit_offset<2>::value,MASK,true,Traits>(s,d,k,c,cur.n); break;
+            case 3:  radixsort_scatter<T,digit_offset<3>::value,MASK,true,Traits>(s,d,k,c,cur.n); break;
+            case 4:  radixsort_scatter<T,digit_offset<4>::value,MASK,true,Traits>(s,d,k,c,cur.n); break;
+            case 5:  radixsort_scatter<T,digit_offset<5>::value,MASK,true,Traits>(s,d,k,c,cur.n); break;
+            case 6:  radixsort_scatter<T,digit_offset<6>::value,MASK,true,Traits>(s,d,k,c,cur.n); break;
+            default: radixsort_scatter<T,digit_offset<7>::value,MASK,true,Traits>(s,d,k,c,cur.n); break;
+        }
+    }
+
+    void start(const node &x)
+    {
+        cur=x; pos=0; phase=COUNT;
+        for(std::size_t j=0;j<2*SIZE;++j) c[j]=0;
+    }
+
+    // Moves data of the current node from buffer 'from' to 'dest'.
+    void copy_or_next(unsigned from)
+    {
+        if(dest>=0&&from!=unsigned(dest)) {cur.in=from; pos=0; phase=COPY;}
+        else {out=from; next();}
+    }
+
+    // Current node is distributed by its digit, data is in buffer 'in',
+    // buckets are [b[j],c[j]) (or the whole node, if pass was skipped).
+    void done_node(unsigned in)
+    {
+        bool skipped=(phase==COUNT);
+        if(!msd)
+        {
+            if(cur.shift+BITS>=KEYBITS) {copy_or_next(in); return;}
+            node x={0,size,unsigned(cur.shift+BITS),in};
+            start(x);
+            return;
+        }
+        if(cur.shift==0) {copy_or_next(in); return;}
+        if(skipped)
+        {
+            node x={cur.begin,cur.n,unsigned(cur.shift-BITS),in};
+            start(x);
+            return;
+        }
+        cur.in=in; leaf=SIZE; phase=LEAVES;
+    }
+
+    // Walks buckets of the current node from the last one, sorting leaves
+    // into 'dest' right away and pushing the rest, until the budget runs
+    // out (overshooting it by less than one leaf).
+    void leaves(std::size_t &budget)
+    {
+        using std::size_t;
+        const unsigned in=cur.in;
+        T *s=buf[in]+cur.begin,*d=buf[!in]+cur.begin;
+        while(leaf>0&&budget>0)
+        {
+            size_t j=--leaf,lo=b[j],m=c[j]-b[j];
+            if(m==0) continue;
+            if(m>=THRESHOLD)
+            {
+                node x={cur.begin+lo,m,unsigned(cur.shift-BITS),in};
+                stack[top++]=x;
+                continue;
+            }
+            if(m==1) {if(unsigned(dest)!=in) d[lo]=s[lo];}
+            else
+            {
+                RADIXSORT_STAT(fallback_calls,1);
+                fallback_sort<T,Traits>(s+lo,d+lo,m,unsigned(dest)==in?0:1);
+            }
+            work+=m;
+            budget-=(m<budget?m:budget);
+        }
+        if(leaf==0) next();
+    }
+
+    void next()
+    {
+        if(top==0) {phase=DONE; if(msd) out=unsigned(dest); return;}
+        start(stack[--top]);
+    }
+
+    T *buf[2];
+    std::size_t size;
+    bool msd;
+    int dest;      // Buffer the output must end up in, -1 for don't care.
+    unsigned out;  // Buffer the output is in.
+    node cur;
+    int phase;
+    std::size_t pos,work;
+    std::size_t leaf; // Buckets of the current node left to walk.
+    std::size_t c[2*SIZE],b[SIZE];
+    node stack[(KEYBITS+BITS-1)/BITS*SIZE];
+    std::size_t top;
+};
+
+// Coroutine sort tasks.
+//
+// radix_sort_stable_task() returns a suspended C++20 coroutine, which
+// does about 'quantum' elements of work per resume() and then suspends,
+// so that a cooperative scheduler can interleave a big sort with other
+// work. The coroutine frame is allocated with operator new.
+
+#if defined(__cpp_impl_coroutine)&&__cplusplus>=202002L
+#include <coroutine>
+
+template<typename T>
+class radix_sort_task
+{
+public:
+    struct promise_type
+    {
+        T *result;
+        promise_type():result(0) {}
+        radix_sort_task get_return_object() {return radix_sort_task(std::coroutine_handle<promise_type>::from_promise(*this));}
+        std::suspend_always initial_suspend() noexcept {return {};}
+        std::suspend_always final_suspend() noexcept {return {};}
+        void return_value(T *r) {result=r;}
+        void unhandled_exception() {throw;}
+    };
+
+    radix_sort_task(radix_sort_task &&other) noexcept:h(other.h) {other.h=nullptr;}
+    radix_sort_task &operator=(radix_sort_task &&other) noexcept {if(this!=&other) {if(h) h.destroy(); h=other.h; other.h=nullptr;} return *this;}
+    ~radix_sort_task() {if(h) h.destroy();}
+
+    // Runs until the next suspension. Returns true when sorting is done.
+    bool resume() {if(!h.done()) h.resume(); return h.done();}
+    bool done() const {return h.done();}
+    // Sorted output (null until done).
+    T *result() const {return h.promise().result;}
+
+private:
+    explicit radix_sort_task(std::coroutine_handle<promise_type> handle):h(handle) {}
+    std::coroutine_handle<promise_type> h;
+};
+
+template<typename T,typename Traits>
+inline radix_sort_task<T> radix_sort_stable_task(T *src,T* tmp,std::size_t n,int destination,int mode,std::size_t quantum)
+{
+    radix_sort_incremental<T,Traits> s;
+    s.init(src,tmp,n,destination,mode);
+    while(!s.step(quantum)) co_await std::suspend_always();
+    co_return s.result();
+}
+#endif
+
+// Re-sorting.
+//
+// For data that changes little between calls (e. g. per-frame depth sort),
+// radix_sort_resort() takes the previous sorted order in which only the
+// listed elements may have changed keys. Unchanged elements are still in
+// order, so only the changed ones are radix sorted, and then merged back.
+// When too many elements changed this is slower than just sorting
+// everything, so radix_sort_stable() is used instead (which orders ties
+// between changed and unchanged elements differently, see below).
+
+// Re-sort if at most 1/RADIXSORT_RESORT_RATIO of elements changed, otherwise
+// sort everything. Experimentally chosen.
+#ifndef RADIXSORT_RESORT_RATIO
+#define RADIXSORT_RESORT_RATIO 4
+#endif
+
+// Merges sorted runs a[0..na) and b[0..nb) into dst; a wins ties.
+template<typename T,typename Traits>
+static inline void radixsort_merge(const T *a,std::size_t na,const T *b,std::size_t nb,T *dst)
+{
+    RADIXSORT_TRACE_SPAN("merge",na+nb,-1);
+    const T *ae=a+na,*be=b+nb;
+    if(na>0&&nb>0)
+    {
+        for(;;)
+        {
+            if(Traits::get_key(*b)<Traits::get_key(*a))
+            {
+                *dst++=*b++;
+                if(b==be) break;
+            }
+            else
+            {
+                *dst++=*a++;
+                if(a==ae) break;
+            }
+        }
+    }
+    while(a!=ae) *dst++=*a++;
+    while(b!=be) *dst++=*b++;
+}
+
+// tmp[0..n-m) holds unchanged elements, tmp[n-m..n) changed ones.
+template<typename T,typename Traits>
+static inline void radixsort_resort_finish(T *data,T *tmp,std::size_t n,std::size_t m)
+{
+    T *changed=radix_sort_stable<T,Traits>(tmp+(n-m),data,m,0,-1);
+    radixsort_merge<T,Traits>(tmp,n-m,changed,m,data);
+}
+
+// 'data' is the previous output of a sort (n elements), where only the
+// elements at positions changed[0..m) (ascending, no duplicates) may have
+// new keys. 'tmp' is a buffer of n elements. On return 'data' is sorted.
+// Unchanged elements keep their relative order, and so do changed ones.
+// Order of ties between the two depends on m: when only the changed
+// elements are sorted and merged (m<=n/RADIXSORT_RESORT_RATIO), unchanged
+// elements go before changed ones with equal keys; otherwise everything is
+// sorted stably, so ties stay in their previous positions' order.
+template<typename T,typename Traits>
+inline void radix_sort_resort(T *data,T *tmp,std::size_t n,const std::size_t *changed,std::size_t m)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_resort",n,-1);
+    if(m==0) return;
+    if(m>n/RADIXSORT_RESORT_RATIO)
+    {
+        radixsort_stable<T,Traits>(data,tmp,n,0,-1,0);
+        return;
+    }
+    size_t u=0,c=n-m,prev=0;
+    for(size_t k=0;k<m;++k)
+    {
+        size_t i=changed[k];
+        for(;prev<i;++prev) tmp[u++]=data[prev];
+        tmp[c++]=data[i];
+        prev=i+1;
+    }
+    for(;prev<n;++prev) tmp[u++]=data[prev];
+    radixsort_resort_finish<T,Traits>(data,tmp,n,m);
+}
+
+// Same as above, but changed elements are given as a bitmap: element i
+// has changed if bit (i%8) of changed[i/8] is set. Ties are ordered as
+// above, with m being the number of set bits.
+template<typename T,typename Traits>
+inline void radix_sort_resort(T *data,T *tmp,std::size_t n,const unsigned char *changed)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_resort",n,-1);
+    size_t m=0;
+    for(size_t i=0;i<n/8;++i)
+    {
+        unsigned b=changed[i];
+        b=(b&0x55u)+((b>>1)&0x55u);
+        b=(b&0x33u)+((b>>2)&0x33u);
+        m+=(b&0x0Fu)+(b>>4);
+    }
+    for(size_t i=n&~size_t(7);i<n;++i) m+=(changed[i>>3]>>(i&7))&1u;
+    if(m==0) return;
+    if(m>n/RADIXSORT_RESORT_RATIO)
+    {
+        radixsort_stable<T,Traits>(data,tmp,n,0,-1,0);
+        return;
+    }
+    size_t u=0,c=n-m;
+    for(size_t i=0;i<n;i+=8)
+    {
+        unsigned b=changed[i>>3];
+        size_t e=(n-i<8?n-i:8);
+        if(b==0) {for(size_t j=0;j<e;++j) tmp[u++]=data[i+j];continue;}
+        for(size_t j=0;j<e;++j)
+        {
+            if((b>>j)&1u) tmp[c++]=data[i+j];
+            else tmp[u++]=data[i+j];
+        }
+    }
+    radixsort_resort_finish<T,Traits>(data,tmp,n,m);
+}
+
+// Spatial sorting.
+//
+// radix_sort_spatial() orders 2D or 3D points along a space-filling curve
+// (Morton, i. e. Z-order, or Hilbert), e. g. to improve locality of
+// particles or mesh primitives. Coordinates are quantized to 16 (2D) or
+// 10 (3D) bits per axis and interleaved into a 32-bit code, and the
+// histogram of the first digit is counted while the codes are written,
+// so there is no separate pass to build keys. Digits match the code
+// width: 3 passes of 11 (2D) or 10 (3D) bits.
+
+#if defined(__BMI2__)
+#include <immintrin.h> // For _pdep_u32().
+#endif
+
+struct radix_sort_spatial_item
+{
+    unsigned key;   // Curve code, in the top bits.
+    unsigned index; // Position of the point in the input.
+};
+
+struct radixsort_spatial_get_key
+{
+    static inline unsigned get_key(const radix_sort_spatial_item &src) {return src.key;}
+};
+
+// Spreads the low 16 bits of v to even bits.
+static inline unsigned radixsort_spread2(unsigned v)
+{
+#if defined(__BMI2__)
+    return _pdep_u32(v,0x55555555u);
+#else
+    v&=0x0000FFFFu;
+    v=(v|(v<<8))&0x00FF00FFu;
+    v=(v|(v<<4))&0x0F0F0F0Fu;
+    v=(v|(v<<2))&0x33333333u;
+    v=(v|(v<<1))&0x55555555u;
+    return v;
+#endif
+}
+
+// Spreads the low 10 bits of v to every third bit.
+static inline unsigned radixsort_spread3(unsigned v)
+{
+#if defined(__BMI2__)
+    return _pdep_u32(v,0x09249249u);
+#else
+    v&=0x000003FFu;
+    v=(v|(v<<16))&0x030000FFu;
+    v=(v|(v<<8))&0x0300F00Fu;
+    v=(v|(v<<4))&0x030C30C3u;
+    v=(v|(v<<2))&0x09249249u;
+    return v;
+#endif
+}
+
+// One step of the transform below: inverts low bits of x0 if bit q of xi
+// is set, otherwise exchanges low bits of x0 and xi. Branch-free, as the
+// bits are random.
+static inline void radixsort_hilbert_step(unsigned &x0,unsigned &xi,unsigned q)
+{
+    unsigned p=q-1,m=0u-unsigned((xi&q)!=0);
+    unsigned t=(x0^xi)&p&~m;
+    x0^=(p&m)^t;
+    xi^=t;
+}
+
+// Transforms coordinates (BITS each) in place so that interleaving them
+// gives the Hilbert code (J. Skilling, "Programming the Hilbert curve").
+// Written out for 2 and 3 dimensions, so that coordinates stay in
+// registers.
+template<unsigned DIMS,unsigned BITS>
+static inline void radixsort_hilbert(unsigned *x)
+{
+    unsigned x0=x[0],x1=x[1],x2=(DIMS>2?x[2]:0u);
+    for(unsigned q=1u<<(BITS-1);q>1;q>>=1)
+    {
+        radixsort_hilbert_step(x0,x0,q);
+        radixsort_hilbert_step(x0,x1,q);
+        if(DIMS>2) radixsort_hilbert_step(x0,x2,q);
+    }
+    x1^=x0;
+    x2^=x1;
+    unsigned last=(DIMS>2?x2:x1),t=0;
+    for(unsigned q=1u<<(BITS-1);q>1;q>>=1)
+        t^=(q-1)&(0u-unsigned((last&q)!=0));
+    x[0]=x0^t;
+    x[1]=x1^t;
+    if(DIMS>2) x[2]=x2^t;
+}
+
+// Curve code of quantized coordinates; x[0] goes to the most significant
+// bit of each group.
+template<unsigned DIMS,bool HILBERT>
+static inline unsigned radixsort_curve_code(unsigned *x)
+{
+    if(HILBERT) radixsort_hilbert<DIMS,(DIMS==2?16:10)>(x);
+    unsigned code=0;
+    for(unsigned d=0;d<DIMS;++d)
+        code|=(DIMS==2?radixsort_spread2(x[d]):radixsort_spread3(x[d]))<<(DIMS-1-d);
+    return code;
+}
+
+template<typename C,unsigned DIMS,bool HILBERT>
+static inline radix_sort_spatial_item *radixsort_spatial(const C *const *axes,std::size_t stride,std::size_t n,const double *lo,const double *scale,radix_sort_spatial_item *buf,radix_sort_spatial_item *tmp)
+{
+    using std::size_t;
+    typedef radix_sort_spatial_item T;
+    typedef radixsort_spatial_get_key Traits;
+    static const unsigned AXIS_BITS=(DIMS==2?16:10);
+    static const size_t WIDTH=DIMS*AXIS_BITS;
+    static const size_t BITS=(WIDTH+2)/3;
+    static const size_t OFFSET=sizeof(unsigned)*CHAR_BIT-WIDTH;
+    static const size_t SIZE=size_t(1)<<BITS;
+    static const size_t MASK=SIZE-1;
+    const double top=double((1u<<AXIS_BITS)-1);
+    RADIXSORT_STAT(passes,1);
+    size_t c[2*SIZE]={0};
+    {
+        RADIXSORT_TRACE_SPAN("keys",n,OFFSET);
+        for(size_t i=0;i<n;++i)
+        {
+            unsigned x[DIMS];
+            for(unsigned d=0;d<DIMS;++d)
+            {
+                double v=(double(axes[d][i*stride])-lo[d])*scale[d];
+                x[d]=v>0.0?unsigned(int(v<top?v:top)):0u; // Also maps NaN to 0.
+            }
+            unsigned code=radixsort_curve_code<DIMS,HILBERT>(x);
+            buf[i].key=code<<OFFSET;
+            buf[i].index=unsigned(i);
+            ++c[2*(code&MASK)+(i&1)];
+        }
+    }
+    T *src=buf,*dst=tmp;
+    if(radixsort_prefix<SIZE>(c,n)) // All keys are in the same bucket.
+    {
+        RADIXSORT_STAT(passes_skipped,1);
+        src=tmp;dst=buf;
+    }
+    else radixsort_scatter<T,OFFSET,MASK,true,Traits>(src,dst,n,c);
+    return radix_sort_lsd_impl<T,WIDTH-BITS,BITS,Traits>(dst,src,n);
+}
+
+// Sorts n points (z is null for 2D) along a space-filling curve: 'curve'
+// is 0 for Morton and 1 for Hilbert. Coordinate of point i is axis[i*stride]
+// (so 'stride' is 1 for SoA; for AoS pass &pts[0].x, &pts[0].y and
+// sizeof(pts[0])/sizeof(pts[0].x)). 'bounds' is {min x,min y,[min z],
+// max x,max y,[max z]}, or null to compute it from the points; points
+// outside are clamped to it. 'buf' and 'tmp' are n items each. Returns
+// the sorted items (either 'buf' or 'tmp'), whose 'index' fields are the
+// permutation. n must be less than 2^32.
+template<typename C>
+inline radix_sort_spatial_item *radix_sort_spatial(const C *x,const C *y,const C *z,std::size_t stride,std::size_t n,const double *bounds,int curve,radix_sort_spatial_item *buf,radix_sort_spatial_item *tmp)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_spatial",n,-1);
+    const C *axes[3]={x,y,z};
+    unsigned dims=(z?3:2);
+    double lo[3]={0.0,0.0,0.0},hi[3]={0.0,0.0,0.0},scale[3];
+    for(unsigned d=0;d<dims;++d)
+    {
+        if(bounds) {lo[d]=bounds[d];hi[d]=bounds[dims+d];}
+        else if(n>0)
+        {
+            lo[d]=hi[d]=double(axes[d][0]);
+            for(size_t i=1;i<n;++i)
+            {
+                double v=double(axes[d][i*stride]);
+                if(v<lo[d]) lo[d]=v;
+                if(v>hi[d]) hi[d]=v;
+            }
+        }
+        double top=double((1u<<(dims==2?16:10))-1);
+        scale[d]=(hi[d]>lo[d]?top/(hi[d]-lo[d]):0.0);
+    }
+    radixsort_stats_begin();
+    RADIXSORT_STAT(lsd_calls,1);
+    radix_sort_spatial_item *ret;
+    if(dims==2) ret=(curve==1?radixsort_spatial<C,2,true>(axes,stride,n,lo,scale,buf,tmp):radixsort_spatial<C,2,false>(axes,stride,n,lo,scale,buf,tmp));
+    else        ret=(curve==1?radixsort_spatial<C,3,true>(axes,stride,n,lo,scale,buf,tmp):radixsort_spatial<C,3,false>(axes,stride,n,lo,scale,buf,tmp));
+    radixsort_stats_end();
+    return ret;
+}
+
+// Reorders data by the result of radix_sort_spatial(): dst[i]=src[order[i].index].
+template<typename T>
+inline void radix_sort_spatial_gather(const T *src,const radix_sort_spatial_item *order,std::size_t n,T *dst)
+{
+    using std::size_t;
+    static const size_t AHEAD=16;
+    for(size_t i=0;i<n;++i)
+    {
+        if(i+AHEAD<n) radixsort_prefetch(src+order[i+AHEAD].index);
+        dst[i]=src[order[i].index];
+    }
+}
+
+// Applying permutations.
+//
+// After sorting {key,index} pairs, other arrays (e. g. SoA columns) often
+// have to be put into the same order. radix_sort_permute_inplace() does it
+// in place, by following cycles of the permutation (swapping elements
+// of all columns at once), with a caller-supplied bitmap of visited
+// positions as the only extra memory. radix_sort_permute_gather() instead
+// gathers columns one at a time into a scratch buffer (with prefetching)
+// and copies them back, so peak memory is one column, not all of them.
+// Following cycles is bound by memory latency (the next position is only
+// known after the current one is read), and is several times slower than
+// gathering for random permutations, so it is for when memory is tight.
+// The permutation is perm[i*stride], i. e. 'perm' may point to the index
+// field of sorted structs (stride being in units of the index type), and
+// the result is column[i]=old_column[perm[i*stride]].
+
+struct radix_sort_column
+{
+    void *data;       // Array of n elements.
+    std::size_t size; // Element size, in bytes.
+};
+
+template<std::size_t SIZE>
+static inline void radixsort_swap_bytes(unsigned char *a,unsigned char *b)
+{
+    unsigned char t[SIZE];
+    std::memcpy(t,a,SIZE);
+    std::memcpy(a,b,SIZE);
+    std::memcpy(b,t,SIZE);
+}
+
+static inline void radixsort_swap_bytes(unsigned char *a,unsigned char *b,std::size_t size)
+{
+    switch(size)
+    {
+        case 1: radixsort_swap_bytes<1>(a,b); return;
+        case 2: radixsort_swap_bytes<2>(a,b); return;
+        case 4: radixsort_swap_bytes<4>(a,b); return;
+        case 8: radixsort_swap_bytes<8>(a,b); return;
+        case 16: radixsort_swap_bytes<16>(a,b); return;
+    }
+    for(;size>=16;size-=16,a+=16,b+=16) radixsort_swap_bytes<16>(a,b);
+    for(;size>0;--size,++a,++b) radixsort_swap_bytes<1>(a,b);
+}
+
+// 'visited' is (n+7)/8 bytes of scratch.
+template<typename I>
+inline void radix_sort_permute_inplace(const I *perm,std::size_t stride,std::size_t n,const radix_sort_column *cols,std::size_t ncols,unsigned char *visited)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_permute_inplace",n,-1);
+    std::memset(visited,0,(n+7)/8);
+    for(size_t i=0;i<n;++i)
+    {
+        if((visited[i>>3]>>(i&7))&1u) continue;
+        // Swapping j with perm[j] puts the right element into j, and
+        // moves the cycle's first element along, until the cycle closes.
+        for(size_t j=i;;)
+        {
+            visited[j>>3]|=(unsigned char)(1u<<(j&7));
+            size_t k=size_t(perm[j*stride]);
+            if(k==i) break;
+            radixsort_prefetch(perm+k*stride); // Next step's index.
+            for(size_t c=0;c<ncols;++c)
+            {
+                unsigned char *p=(unsigned char*)cols[c].data;
+                size_t s=cols[c].size;
+                radixsort_swap_bytes(p+j*s,p+k*s,s);
+            }
+            j=k;
+        }
+    }
+}
+
+template<typename E,typename I>
+static inline void radixsort_gather(const E *src,E *dst,const I *perm,std::size_t stride,std::size_t n)
+{
+    using std::size_t;
+    static const size_t AHEAD=16;
+    for(size_t i=0;i<n;++i)
+    {
+        if(i+AHEAD<n) radixsort_prefetch(src+size_t(perm[(i+AHEAD)*stride]));
+        dst[i]=src[size_t(perm[i*stride])];
+    }
+}
+
+// 'scratch' is n elements of the largest column.
+template<typename I>
+inline void radix_sort_permute_gather(const I *perm,std::size_t stride,std::size_t n,const radix_sort_column *cols,std::size_t ncols,void *scratch)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_permute_gather",n,-1);
+    unsigned char *t=(unsigned char*)scratch;
+    for(size_t c=0;c<ncols;++c)
+    {
+        unsigned char *p=(unsigned char*)cols[c].data;
+        size_t s=cols[c].size;
+        switch(s)
+        {
+            case 1: radixsort_gather(p,t,perm,stride,n); break;
+            case 2: radixsort_gather((const unsigned short*)p,(unsigned short*)t,perm,stride,n); break;
+            case 4: radixsort_gather((const unsigned int*)p,(unsigned int*)t,perm,stride,n); break;
+            case 8: radixsort_gather((const unsigned long long*)p,(unsigned long long*)t,perm,stride,n); break;
+            default:
+                for(size_t i=0;i<n;++i)
+                {
+                    if(i+16<n) radixsort_prefetch(p+size_t(perm[(i+16)*stride])*s);
+                    std::memcpy(t+i*s,p+size_t(perm[i*stride])*s,s);
+                }
+        }
+        std::memcpy(p,t,n*s);
+    }
+}
+
+// Building CSR (compressed sparse row) matrices.
+//
+// radix_sort_coo_to_csr() turns (row,col,val) triples into CSR: row
+// offsets, and columns and values ordered by row. This is a counting
+// sort with the row as a single digit, so the histogram of rows is
+// turned into the row offsets in place, and entries are scattered
+// straight to the output: 2 passes over the triples. If columns have to
+// be ordered within rows, columns are sorted first (stably, the same way),
+// with both histograms counted in one pass: 3 passes. Duplicates (equal
+// row and column) can then be summed in one more pass over the output.
+
+// Flags for radix_sort_coo_to_csr().
+enum
+{
+    RADIX_SORT_CSR_SORT_COLUMNS=1,  // Order entries within each row by column.
+    RADIX_SORT_CSR_SUM_DUPLICATES=2 // Sum values of equal (row,col); implies the above.
+};
+
+// Offset of values in 'scratch' of radix_sort_coo_to_csr(), in bytes,
+// after column offsets, rows and columns, rounded up to a multiple of
+// sizeof(V), so that values are aligned (if 'scratch' is).
+template<typename V>
+static inline std::size_t radixsort_csr_vals_offset(std::size_t nnz,std::size_t ncols)
+{
+    std::size_t ret=(ncols+1)*sizeof(std::size_t)+2*nnz*sizeof(unsigned);
+    return (ret+sizeof(V)-1)/sizeof(V)*sizeof(V);
+}
+
+// Size of 'scratch' for radix_sort_coo_to_csr(), in bytes.
+template<typename V>
+inline std::size_t radix_sort_coo_to_csr_scratch(std::size_t nnz,std::size_t ncols,int flags)
+{
+    if(!(flags&(RADIX_SORT_CSR_SORT_COLUMNS|RADIX_SORT_CSR_SUM_DUPLICATES))) return 0;
+    return radixsort_csr_vals_offset<V>(nnz,ncols)+nnz*sizeof(V);
+}
+
+// Turns counts c[1..m] into offsets: c[0..m] is the start of each bucket.
+static inline void radixsort_offsets(std::size_t *c,std::size_t m)
+{
+    c[0]=0;
+    for(std::size_t j=0;j<m;++j) c[j+1]+=c[j];
+}
+
+// Stable scatter of (col,val) by 'key'; c[k] is the start of bucket k,
+// and is advanced to its end. Optionally also scatters rows.
+template<typename V>
+static inline void radixsort_csr_scatter(const unsigned *key,const unsigned *rows,const unsigned *cols,const V *vals,std::size_t nnz,std::size_t *c,unsigned *out_rows,unsigned *out_cols,V *out_vals)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("scatter",nnz,-1);
+    for(size_t i=0;i<nnz;++i)
+    {
+        size_t p=c[key[i]]++;
+        if(out_rows) out_rows[p]=rows[i];
+        out_cols[p]=cols[i];
+        if(vals) out_vals[p]=vals[i];
+    }
+    RADIXSORT_STAT(bytes_moved,nnz*(sizeof(unsigned)*(out_rows?2:1)+(vals?sizeof(V):0)));
+}
+
+// Converts nnz triples (rows[i],cols[i],vals[i]) with rows[i]<nrows and
+// cols[i]<ncols into CSR: entries of row r are out_cols/out_vals
+// [row_ptr[r],row_ptr[r+1]) (row_ptr has nrows+1 entries). Entries keep
+// their input order within a row, unless 'flags' ask to sort them by
+// column (or to also sum duplicates). 'vals' (and 'out_vals') may be null
+// for pattern only. 'scratch' is radix_sort_coo_to_csr_scratch() bytes,
+// aligned for size_t and V (it is not used, and may be null, if flags are
+// 0). Returns the number of entries in the output.
+template<typename V>
+inline std::size_t radix_sort_coo_to_csr(const unsigned *rows,const unsigned *cols,const V *vals,std::size_t nnz,std::size_t nrows,std::size_t ncols,int flags,std::size_t *row_ptr,unsigned *out_cols,V *out_vals,void *scratch)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_coo_to_csr",nnz,-1);
+    radixsort_stats_begin();
+    RADIXSORT_STAT(lsd_calls,1);
+    for(size_t r=0;r<=nrows;++r) row_ptr[r]=0;
+    if(!(flags&(RADIX_SORT_CSR_SORT_COLUMNS|RADIX_SORT_CSR_SUM_DUPLICATES)))
+    {
+        RADIXSORT_STAT(passes,1);
+        {
+            RADIXSORT_TRACE_SPAN("count",nnz,-1);
+            for(size_t i=0;i<nnz;++i) ++row_ptr[rows[i]+1];
+        }
+        radixsort_offsets(row_ptr,nrows);
+        radixsort_csr_scatter<V>(rows,0,cols,vals,nnz,row_ptr,0,out_cols,out_vals);
+    }
+    else
+    {
+        // Sort by column, then (stably) by row.
+        size_t *col_ptr=(size_t*)scratch;
+        unsigned *tmp_rows=(unsigned*)(col_ptr+ncols+1);
+        unsigned *tmp_cols=tmp_rows+nnz;
+        V *tmp_vals=(V*)((char*)scratch+radixsort_csr_vals_offset<V>(nnz,ncols));
+        for(size_t j=0;j<=ncols;++j) col_ptr[j]=0;
+        RADIXSORT_STAT(passes,2);
+        {
+            RADIXSORT_TRACE_SPAN("count",nnz,-1);
+            for(size_t i=0;i<nnz;++i) {++row_ptr[rows[i]+1];++col_ptr[cols[i]+1];}
+        }
+        radixsort_offsets(row_ptr,nrows);
+        radixsort_offsets(col_ptr,ncols);
+        radixsort_csr_scatter<V>(cols,rows,cols,vals,nnz,col_ptr,tmp_rows,tmp_cols,tmp_vals);
+        radixsort_csr_scatter<V>(tmp_rows,0,tmp_cols,vals?tmp_vals:0,nnz,row_ptr,0,out_cols,out_vals);
+    }
+    // Scatter advanced row_ptr[r] to the end of row r, i. e. the start of
+    // row r+1.
+    for(size_t r=nrows;r>0;--r) row_ptr[r]=row_ptr[r-1];
+    row_ptr[0]=0;
+    if(flags&RADIX_SORT_CSR_SUM_DUPLICATES)
+    {
+        RADIXSORT_TRACE_SPAN("duplicates",nnz,-1);
+        size_t k=0;
+        for(size_t r=0,b=0;r<nrows;++r)
+        {
+            size_t e=row_ptr[r+1];
+            row_ptr[r]=k;
+            for(size_t i=b;i<e;++i)
+            {
+                if(k>row_ptr[r]&&out_cols[k-1]==out_cols[i])
+                {
+                    if(out_vals) out_vals[k-1]+=out_vals[i];
+                    continue;
+                }
+                out_cols[k]=out_cols[i];
+                if(out_vals) out_vals[k]=out_vals[i];
+                ++k;
+            }
+            b=e;
+        }
+        row_ptr[nrows]=k;
+    }
+    radixsort_stats_end();
+    return row_ptr[nrows];
+}
+
+// Suffix arrays.
+//
+// radix_sort_suffix_array() builds the suffix array of a byte string by
+// prefix doubling: each round sorts {(rank of i,rank of i+h),i} records
+// with stable radix sort, and re-ranks suffixes by their first 2h
+// bytes, until all ranks are distinct. The first round sorts by the first
+// 4 bytes directly. Only as many key bits as ranks need are sorted on
+// (LSD, see radix_sort_stable_top()). Ranks and indices are 32-bit, so n
+// must be less than 2^32-1; the same scratch buffers are reused in every
+// round. This takes O(n log(longest repeat)) time, which is fine for
+// typical texts, but degrades on very repetitive ones.
+
+struct radixsort_suffix_record
+{
+    unsigned long long key; // Rank pair.
+    unsigned index;         // Suffix.
+};
+
+struct radixsort_suffix_get_key
+{
+    static inline unsigned long long get_key(const radixsort_suffix_record &src) {return src.key;}
+};
+
+// Sorts records by the top 'bits' bits of their keys (the rest are zero),
+// with LSD, rounding 'bits' up to whole bytes.
+static inline radixsort_suffix_record *radixsort_suffix_sort(radixsort_suffix_record *buf,radixsort_suffix_record *tmp,std::size_t n,unsigned bits)
+{
+    typedef radixsort_suffix_record R;
+    typedef radixsort_suffix_get_key Traits;
+    switch((bits+7)/8)
+    {
+        case 1: case 2: case 3:
+        case 4: return radix_sort_stable_top<R,32,Traits>(buf,tmp,n,-1,0);
+        case 5: return radix_sort_stable_top<R,40,Traits>(buf,tmp,n,-1,0);
+        case 6: return radix_sort_stable_top<R,48,Traits>(buf,tmp,n,-1,0);
+        case 7: return radix_sort_stable_top<R,56,Traits>(buf,tmp,n,-1,0);
+        default: return radix_sort_stable_top<R,64,Traits>(buf,tmp,n,-1,0);
+    }
+}
+
+// Size of 'scratch' for radix_sort_suffix_array(), in bytes.
+inline std::size_t radix_sort_suffix_array_scratch(std::size_t n)
+{
+    return n*(2*sizeof(radixsort_suffix_record)+sizeof(unsigned));
+}
+
+// Writes suffixes of text[0..n) in lexicographic order (shorter suffix
+// first on ties) to sa[0..n). 'scratch' is radix_sort_suffix_array_scratch()
+// bytes, aligned for unsigned long long.
+inline void radix_sort_suffix_array(const unsigned char *text,std::size_t n,unsigned *sa,void *scratch)
+{
+    using std::size_t;
+    typedef radixsort_suffix_record R;
+    RADIXSORT_TRACE_SPAN("radix_sort_suffix_array",n,-1);
+    R *buf=(R*)scratch,*tmp=buf+n;
+    unsigned *rank=(unsigned*)(tmp+n);
+    // Ranks are 1..n (0 is past the end), in B bits.
+    unsigned B=1;
+    while(B<32&&(std::size_t(1)<<B)<=n) ++B;
+    // Keys are kept in the top bits, so that only those are sorted on.
+    // First 4 bytes, as 1..256 each (0 is past the end).
+    unsigned bits=36;
+    for(size_t i=0;i<n;++i)
+    {
+        unsigned long long k=0;
+        for(size_t j=0;j<4;++j) k=(k<<9)|(i+j<n?text[i+j]+1u:0u);
+        buf[i].key=k<<(64-bits);
+        buf[i].index=unsigned(i);
+    }
+    for(size_t h=4;;h*=2)
+    {
+        const R *s=radixsort_suffix_sort(buf,tmp,n,bits);
+        // Rank of a suffix is 1 + the number of suffixes with a smaller
+        // 2h-byte prefix.
+        size_t groups=0;
+        for(size_t j=0,r=0;j<n;++j)
+        {
+            if(j==0||s[j].key!=s[j-1].key) {r=j+1;++groups;}
+            rank[s[j].index]=unsigned(r);
+        }
+        if(groups==n||h>=n)
+        {
+            for(size_t j=0;j<n;++j) sa[j]=s[j].index;
+            return;
+        }
+        bits=2*B;
+        for(size_t i=0;i<n;++i)
+        {
+            buf[i].key=((static_cast<unsigned long long>(rank[i])<<B)|(i+h<n?rank[i+h]:0u))<<(64-bits);
+            buf[i].index=unsigned(i);
+        }
+    }
+}
+
+// Radix heap.
+//
+// radix_heap<K,V> is a monotone priority queue: keys come out in
+// non-decreasing order, and a pushed key must not be less than the last
+// popped one (e. g. Dijkstra's algorithm, or event simulation with
+// non-negative delays). Elements are kept in buckets by the highest bit
+// in which their key differs from the last popped key, so push is O(1),
+// and each element moves to a lower bucket at most sizeof(K)*CHAR_BIT
+// times. When bucket 0 (keys equal to the last popped one) runs empty,
+// the lowest non-empty bucket is redistributed the way an MSD pass
+// scatters: a histogram of target buckets, then a scatter. Bulk push()
+// goes through the same path. Buckets are std::vector's, so, unlike the
+// rest of the library, the heap allocates memory.
+
+// Number of significant bits in x (0 for 0).
+template<typename K>
+static inline unsigned radixsort_bit_width(K x)
+{
+#if defined(__GNUC__)
+    if(x==0) return 0;
+    if(sizeof(K)<=sizeof(unsigned)) return unsigned(sizeof(unsigned)*CHAR_BIT)-unsigned(__builtin_clz(unsigned(x)));
+    return unsigned(sizeof(unsigned long long)*CHAR_BIT)-unsigned(__builtin_clzll((unsigned long long)x));
+#else
+    unsigned r=0;
+    for(;x;x>>=1) ++r;
+    return r;
+#endif
+}
+
+// K is an unsigned integer type, V is the payload.
+template<typename K,typename V>
+class radix_heap
+{
+public:
+    struct entry
+    {
+        K key;
+        V value;
+    };
+    radix_heap():last_(0),size_(0) {}
+    std::size_t size() const {return size_;}
+    bool empty() const {return size_==0;}
+    // Last popped key (initially 0).
+    K last() const {return last_;}
+    void push(K key,const V &value)
+    {
+        entry e={key,value};
+        b_[radixsort_bit_width(K(key^last_))].push_back(e);
+        ++size_;
+    }
+    // Pushes n elements at once.
+    void push(const entry *src,std::size_t n)
+    {
+        distribute(src,n);
+        size_+=n;
+    }
+    // Element with the smallest key; the heap must not be empty.
+    const entry &top()
+    {
+        assert(!empty());
+        refill();
+        return b_[0].back();
+    }
+    // Removes the element with the smallest key; the heap must not be empty.
+    void pop()
+    {
+        assert(!empty());
+        refill();
+        b_[0].pop_back();
+        --size_;
+    }
+    // Pops up to 'max' elements with the smallest keys to dst, in order.
+    // Returns the number of elements popped.
+    std::size_t pop(entry *dst,std::size_t max)
+    {
+        using std::size_t;
+        size_t k=0;
+        while(k<max&&size_>0)
+        {
+            refill();
+            std::vector<entry> &b=b_[0];
+            size_t m=b.size(),r=(m<max-k?m:max-k);
+            for(size_t i=0;i<r;++i) dst[k+i]=b[m-r+i]; // All have the same key.
+            b.resize(m-r);
+            k+=r;
+            size_-=r;
+        }
+        return k;
+    }
+    void clear()
+    {
+        for(unsigned j=0;j<BUCKETS;++j) b_[j].clear();
+        last_=0;
+        size_=0;
+    }
+private:
+    static const unsigned BUCKETS=sizeof(K)*CHAR_BIT+1;
+    // Histogram of target buckets, then scatter.
+    void distribute(const entry *src,std::size_t n)
+    {
+        using std::size_t;
+        RADIXSORT_TRACE_SPAN("distribute",n,-1);
+        size_t c[BUCKETS]={0};
+        for(size_t i=0;i<n;++i) ++c[radixsort_bit_width(K(src[i].key^last_))];
+        entry *d[BUCKETS];
+        for(unsigned j=0;j<BUCKETS;++j)
+        {
+            size_t m=b_[j].size();
+            if(c[j]) b_[j].resize(m+c[j]);
+            d[j]=(c[j]?&b_[j][m]:0);
+        }
+        for(size_t i=0;i<n;++i) *d[radixsort_bit_width(K(src[i].key^last_))]++=src[i];
+    }
+    // Makes sure bucket 0 is not empty, unless the heap is.
+    void refill()
+    {
+        using std::size_t;
+        if(!b_[0].empty()) return;
+        unsigned j=1;
+        while(j<BUCKETS&&b_[j].empty()) ++j;
+        if(j==BUCKETS) return;
+        std::vector<entry> &b=b_[j];
+        K m=b[0].key;
+        for(size_t i=1;i<b.size();++i) if(b[i].key<m) m=b[i].key;
+        last_=m;
+        // All elements go to lower buckets.
+        t_.swap(b);
+        distribute(&t_[0],t_.size());
+        t_.clear();
+    }
+    std::vector<entry> b_[BUCKETS];
+    std::vector<entry> t_;
+    K last_;
+    std::size_t size_;
+};
+
+// Search layouts.
+//
+// Binary search over a sorted array is branchy, and every step of it is a
+// cache miss on a different line. The sorted output can be rearranged
+// (in one pass, in O(n)) into a layout that is faster to search:
+//   * Eytzinger (BFS) order: radix_sort_eytzinger() places the implicit
+//     binary tree so that children of node k (1-based) are 2k and 2k+1.
+//     Search is branch-free, and the nodes of the next few levels are
+//     adjacent, so they can be prefetched.
+//   * Static B-tree (S-tree) order: radix_sort_btree() stores nodes of
+//     RADIXSORT_BTREE_LINE bytes (as many elements as fit; children of
+//     node k are k*(B+1)+1..k*(B+1)+B+1), so each level is one cache line.
+//     Every element is stored once, in internal nodes as well as leaves
+//     (there is no separate leaf level as in a B+tree).
+//     Unused slots at the end are filled with copies of the largest
+//     element.
+// Lookups return the position in the layout array of the first element
+// whose key is not less than the query (like std::lower_bound()), or the
+// size of the layout array if there is none. Batch versions process
+// RADIXSORT_SEARCH_BATCH queries in lockstep, so that their cache misses
+// overlap.
+
+#ifndef RADIXSORT_BTREE_LINE
+#define RADIXSORT_BTREE_LINE 64
+#endif
+
+#ifndef RADIXSORT_SEARCH_BATCH
+#define RADIXSORT_SEARCH_BATCH 16
+#endif
+
+// Number of trailing 1 bits in k.
+static inline unsigned radixsort_trailing_ones(std::size_t k)
+{
+#if defined(__GNUC__)
+    return unsigned(__builtin_ctzll(~(unsigned long long)k));
+#else
+    unsigned r=0;
+    for(;k&1;k>>=1) ++r;
+    return r;
+#endif
+}
+
+template<typename T>
+static inline void radixsort_eytzinger(const T *sorted,std::size_t n,T *out,std::size_t k,std::size_t &t)
+{
+    if(k>n) return;
+    radixsort_eytzinger(sorted,n,out,2*k,t);
+    out[k-1]=sorted[t++];
+    radixsort_eytzinger(sorted,n,out,2*k+1,t);
+}
+
+// Writes sorted[0..n) to out[0..n) in Eytzinger order (node k at out[k-1]).
+template<typename T>
+inline void radix_sort_eytzinger(const T *sorted,std::size_t n,T *out)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_eytzinger",n,-1);
+    std::size_t t=0;
+    radixsort_eytzinger(sorted,n,out,1,t);
+}
+
+// Lower bound of 'key' in Eytzinger layout 'e' of n elements.
+template<typename T,typename Traits,typename K>
+inline std::size_t radix_sort_eytzinger_lower_bound(const T *e,std::size_t n,K key)
+{
+    using std::size_t;
+    // The 2^d descendants of node k, d levels down, are adjacent; fetch
+    // the ones that fill one cache line (d=4 for 4-byte T).
+    static const size_t AHEAD=(sizeof(T)<=4?16:sizeof(T)<=8?8:sizeof(T)<=16?4:1);
+    size_t k=1;
+    while(k<=n)
+    {
+        if(k*AHEAD<=n) radixsort_prefetch(e+k*AHEAD-1);
+        k=2*k+size_t(Traits::get_key(e[k-1])<key);
+    }
+    // Undo the right turns (and the last left one).
+    k>>=radixsort_trailing_ones(k)+1;
+    return k?k-1:n;
+}
+
+// Batch version: res[i] is the lower bound of keys[i].
+template<typename T,typename Traits,typename K>
+inline void radix_sort_eytzinger_lower_bound(const T *e,std::size_t n,const K *keys,std::size_t m,std::size_t *res)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_eytzinger_lower_bound",m,-1);
+    static const size_t G=RADIXSORT_SEARCH_BATCH;
+    for(size_t b=0;b<m;b+=G)
+    {
+        size_t g=(m-b<G?m-b:G),k[G];
+        for(size_t j=0;j<g;++j) k[j]=1;
+        // All searches take the same number of steps, give or take one.
+        for(bool any=true;any;)
+        {
+            any=false;
+            for(size_t j=0;j<g;++j)
+                if(k[j]<=n)
+                {
+                    radixsort_prefetch(e+2*k[j]-1);
+                    k[j]=2*k[j]+size_t(Traits::get_key(e[k[j]-1])<keys[b+j]);
+                    any=true;
+                }
+        }
+        for(size_t j=0;j<g;++j)
+        {
+            size_t r=k[j]>>(radixsort_trailing_ones(k[j])+1);
+            res[b+j]=(r?r-1:n);
+        }
+    }
+}
+
+// Elements per node of radix_sort_btree() layout.
+template<typename T>
+inline std::size_t radix_sort_btree_node()
+{
+    return (sizeof(T)<RADIXSORT_BTREE_LINE?RADIXSORT_BTREE_LINE/sizeof(T):1);
+}
+
+// Size (in elements) of radix_sort_btree() layout of n elements.
+template<typename T>
+inline std::size_t radix_sort_btree_size(std::size_t n)
+{
+    std::size_t B=radix_sort_btree_node<T>();
+    return (n+B-1)/B*B;
+}
+
+template<typename T>
+static inline void radixsort_btree(const T *sorted,std::size_t n,T *out,std::size_t nodes,std::size_t B,std::size_t k,std::size_t &t)
+{
+    if(k>=nodes) return;
+    for(std::size_t i=0;i<B;++i)
+    {
+        radixsort_btree(sorted,n,out,nodes,B,k*(B+1)+i+1,t);
+        out[k*B+i]=sorted[t<n?t++:n-1];
+    }
+    radixsort_btree(sorted,n,out,nodes,B,k*(B+1)+B+1,t);
+}
+
+// Writes sorted[0..n) (n>0) to out[0..radix_sort_btree_size<T>(n)) in
+// static B-tree order.
+template<typename T>
+inline void radix_sort_btree(const T *sorted,std::size_t n,T *out)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_btree",n,-1);
+    std::size_t B=radix_sort_btree_node<T>(),t=0;
+    radixsort_btree(sorted,n,out,radix_sort_btree_size<T>(n)/B,B,0,t);
+}
+
+// Lower bound of 'key' in B-tree layout 'e' of 'size' elements (as
+// returned by radix_sort_btree_size()).
+template<typename T,typename Traits,typename K>
+inline std::size_t radix_sort_btree_lower_bound(const T *e,std::size_t size,K key)
+{
+    using std::size_t;
+    const size_t B=radix_sort_btree_node<T>(),nodes=size/B;
+    size_t k=0,res=size;
+    while(k<nodes)
+    {
+        const T *node=e+k*B;
+        size_t i=0;
+        for(size_t j=0;j<B;++j) i+=size_t(Traits::get_key(node[j])<key); // Node is sorted.
+        if(i<B) res=k*B+i;
+        k=k*(B+1)+i+1;
+    }
+    return res;
+}
+
+// Batch version: res[i] is the lower bound of keys[i].
+template<typename T,typename Traits,typename K>
+inline void radix_sort_btree_lower_bound(const T *e,std::size_t size,const K *keys,std::size_t m,std::size_t *res)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_btree_lower_bound",m,-1);
+    static const size_t G=RADIXSORT_SEARCH_BATCH;
+    const size_t B=radix_sort_btree_node<T>(),nodes=size/B;
+    for(size_t b=0;b<m;b+=G)
+    {
+        size_t g=(m-b<G?m-b:G),k[G];
+        for(size_t j=0;j<g;++j) {k[j]=0;res[b+j]=size;}
+        // Leaves are at most one level apart.
+        for(bool any=true;any;)
+        {
+            any=false;
+            for(size_t j=0;j<g;++j)
+                if(k[j]<nodes)
+                {
+                    const T *node=e+k[j]*B;
+                    size_t i=0;
+                    for(size_t q=0;q<B;++q) i+=size_t(Traits::get_key(node[q])<keys[b+j]);
+                    if(i<B) res[b+j]=k[j]*B+i;
+                    k[j]=k[j]*(B+1)+i+1;
+                    if(k[j]<nodes) radixsort_prefetch(e+k[j]*B);
+                    any=true;
+                }
+        }
+    }
+}
+
+// Compressed output.
+//
+// Sorted keys compress well: differences of adjacent keys are small.
+// radix_sort_compress() encodes keys of sorted output in blocks of
+// RADIXSORT_BLOCK keys: the first key of each block goes to the block
+// index (radix_sort_block), and the differences to the previous key are
+// either bit-packed (with the width of the largest difference in the
+// block) or written as varints (7 bits per byte, LSB first). Blocks start
+// on byte boundaries, so any block can be decoded on its own.
+// The final LSD scatter writes to random positions, so it cannot emit
+// deltas itself; radix_sort_stable_compressed() encodes right after the
+// sort, reading the output once, while its tail is still in cache.
+
+// Keys per block, a multiple of 8 (so blocks of any width end on bytes).
+#ifndef RADIXSORT_BLOCK
+#define RADIXSORT_BLOCK 128
+#endif
+
+// Formats for radix_sort_compress().
+enum
+{
+    RADIX_SORT_PACK_BITS=0,  // Bit-packed differences.
+    RADIX_SORT_PACK_VARINT=1 // Varint differences.
+};
+
+struct radix_sort_block
+{
+    unsigned long long first; // First key.
+    std::size_t offset;       // Byte offset of encoded differences.
+    unsigned count;           // Number of keys (RADIXSORT_BLOCK but the last).
+    unsigned bits;            // Bits per difference (RADIX_SORT_PACK_BITS).
+};
+
+// Number of blocks for n keys.
+inline std::size_t radix_sort_compress_blocks(std::size_t n)
+{
+    return (n+RADIXSORT_BLOCK-1)/RADIXSORT_BLOCK;
+}
+
+// Upper bound on the size of compressed data for n keys of 'key_bytes'
+// bytes (including padding that the decoder may read past the end).
+inline std::size_t radix_sort_compress_bound(std::size_t n,std::size_t key_bytes,int format)
+{
+    std::size_t per_key=(format==RADIX_SORT_PACK_VARINT?(key_bytes*CHAR_BIT+6)/7:key_bytes);
+    return n*per_key+radix_sort_compress_blocks(n)+16;
+}
+
+// Little-endian 8-byte load and store. Byte loops are not merged into
+// a single access at -O2, so little-endian targets use memcpy().
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__) || defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM64)
+#define RADIXSORT_LITTLE_ENDIAN 1
+#endif
+
+static inline unsigned long long radixsort_load64(const unsigned char *p)
+{
+    unsigned long long r=0;
+#ifdef RADIXSORT_LITTLE_ENDIAN
+    std::memcpy(&r,p,8);
+#else
+    for(int i=0;i<8;++i) r|=(unsigned long long)p[i]<<(8*i);
+#endif
+    return r;
+}
+
+static inline void radixsort_store64(unsigned char *p,unsigned long long x)
+{
+#ifdef RADIXSORT_LITTLE_ENDIAN
+    std::memcpy(p,&x,8);
+#else
+    for(int i=0;i<8;++i) {p[i]=(unsigned char)x;x>>=8;}
+#endif
+}
+
+// Writes 'count' values of 'bits' bits (0<bits<=64), returns end.
+template<typename V>
+static inline unsigned char *radixsort_pack(const V *v,std::size_t count,unsigned bits,unsigned char *out)
+{
+    unsigned long long acc=0;
+    unsigned fill=0;
+    for(std::size_t i=0;i<count;++i)
+    {
+        acc|=(unsigned long long)v[i]<<fill;
+        if(fill+bits>=64)
+        {
+            radixsort_store64(out,acc);
+            out+=8;
+            acc=(fill?(unsigned long long)v[i]>>(64-fill):0);
+            fill=fill+bits-64;
+        }
+        else fill+=bits;
+    }
+    for(;fill>0;fill=(fill>8?fill-8:0)) {*out++=(unsigned char)acc;acc>>=8;}
+    return out;
+}
+
+template<typename T,typename Traits>
+inline std::size_t radix_sort_compress(const T *sorted,std::size_t n,int format,unsigned char *out,radix_sort_block *index)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_compress",n,-1);
+    unsigned char *p=out;
+    unsigned long long d[RADIXSORT_BLOCK];
+    for(size_t b=0,i=0;i<n;++b,i+=RADIXSORT_BLOCK)
+    {
+        size_t m=(n-i<RADIXSORT_BLOCK?n-i:RADIXSORT_BLOCK);
+        radix_sort_block &blk=index[b];
+        blk.first=(unsigned long long)Traits::get_key(sorted[i]);
+        blk.offset=size_t(p-out);
+        blk.count=unsigned(m);
+        unsigned long long all=0;
+        for(size_t j=1;j<m;++j)
+        {
+            d[j-1]=(unsigned long long)Traits::get_key(sorted[i+j])-(unsigned long long)Traits::get_key(sorted[i+j-1]);
+            all|=d[j-1];
+        }
+        unsigned bits=0;
+        for(;bits<64&&(all>>bits)!=0;++bits) {}
+        blk.bits=bits;
+        if(format==RADIX_SORT_PACK_VARINT)
+        {
+            for(size_t j=0;j+1<m;++j)
+            {
+                unsigned long long x=d[j];
+                for(;x>=0x80;x>>=7) *p++=(unsigned char)(x|0x80);
+                *p++=(unsigned char)x;
+            }
+        }
+        else if(bits>0) p=radixsort_pack(d,m-1,bits,p);
+    }
+    for(int k=0;k<16;++k) p[k]=0; // Padding for the decoder.
+    return size_t(p-out)+16;
+}
+
+// Decodes one block to dst[0..blk.count).
+template<typename K>
+inline void radix_sort_decompress_block(const unsigned char *data,const radix_sort_block &blk,int format,K *dst)
+{
+    using std::size_t;
+    const unsigned char *p=data+blk.offset;
+    unsigned long long k=blk.first;
+    dst[0]=K(k);
+    if(format==RADIX_SORT_PACK_VARINT)
+    {
+        for(size_t j=1;j<blk.count;++j)
+        {
+            unsigned long long x=0;
+            for(unsigned s=0;;s+=7)
+            {
+                unsigned char c=*p++;
+                x|=(unsigned long long)(c&0x7F)<<s;
+                if(!(c&0x80)) break;
+            }
+            k+=x;
+            dst[j]=K(k);
+        }
+        return;
+    }
+    const unsigned bits=blk.bits;
+    const unsigned long long mask=(bits<64?((unsigned long long)1<<bits)-1:~(unsigned long long)0);
+    size_t pos=0;
+    for(size_t j=1;j<blk.count;++j,pos+=bits)
+    {
+        size_t byte=pos>>3;
+        unsigned sh=unsigned(pos&7);
+        unsigned long long x=radixsort_load64(p+byte)>>sh;
+        if(sh+bits>64) x|=(unsigned long long)p[byte+8]<<(64-sh);
+        k+=x&mask;
+        dst[j]=K(k);
+    }
+}
+
+// Decodes all n keys.
+template<typename K>
+inline void radix_sort_decompress(const unsigned char *data,const radix_sort_block *index,std::size_t n,int format,K *dst)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_decompress",n,-1);
+    for(std::size_t b=0,m=radix_sort_compress_blocks(n);b<m;++b)
+        radix_sort_decompress_block(data,index[b],format,dst+b*RADIXSORT_BLOCK);
+}
+
+// Sorts (as radix_sort_stable() with 'don't care' destination), then
+// compresses the keys. Returns the size of compressed data.
+template<typename T,typename Traits>
+inline std::size_t radix_sort_stable_compressed(T *src,T* tmp,std::size_t n,int mode,int format,unsigned char *out,radix_sort_block *index)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_stable_compressed",n,-1);
+    const T *sorted=radixsort_stable<T,Traits>(src,tmp,n,-1,mode,0);
+    return radix_sort_compress<T,Traits>(sorted,n,format,out,index);
+}
+
+// Packed input.
+//
+// Columns are often stored bit-packed: n values of a fixed width, or
+// frame-of-reference (FOR) blocks of RADIXSORT_BLOCK values, each packed
+// as offsets from the block minimum at the block's own width. Decoding
+// such a column into an array before sorting writes and reads it once
+// more than needed. radix_sort_packed() and radix_sort_packed_for()
+// instead decode a block at a time into a buffer on the stack, both for
+// the histogram and the scatter of the first LSD pass, so the first
+// array of keys written is already sorted by the lowest digit. Remaining
+// passes are the usual radix_sort_lsd_impl(), limited to bytes that the
+// largest possible value has.
+// Layout matches radix_sort_compress(): values are LSB first, in little
+// endian order, and FOR blocks are described by radix_sort_block, with
+// 'first' being the block minimum.
+
+// Decodes 'count' values of 'bits' bits starting at value 'first' from
+// p[0..bytes), adding 'base'.
+template<typename K>
+static inline void radixsort_unpack(const unsigned char *p,std::size_t bytes,std::size_t first,std::size_t count,unsigned bits,K base,K *dst)
+{
+    using std::size_t;
+    const unsigned long long mask=(bits<64?((unsigned long long)1<<bits)-1:~(unsigned long long)0);
+    size_t pos=first*bits,i=0;
+    for(;i<count;++i,pos+=bits) // 9 bytes are readable.
+    {
+        size_t byte=pos>>3;
+        if(byte+9>bytes) break;
+        unsigned sh=unsigned(pos&7);
+        unsigned long long x=radixsort_load64(p+byte)>>sh;
+        if(sh+bits>64) x|=(unsigned long long)p[byte+8]<<(64-sh);
+        dst[i]=K(base+K(x&mask));
+    }
+    for(;i<count;++i,pos+=bits) // Near the end of input.
+    {
+        unsigned long long x=0;
+        for(unsigned got=0;got<bits;)
+        {
+            size_t at=pos+got;
+            x|=(unsigned long long)(p[at>>3]>>(at&7))<<got;
+            got+=8-unsigned(at&7);
+        }
+        dst[i]=K(base+K(x&mask));
+    }
+}
+
+// Sources of blocks of values for radixsort_packed().
+template<typename K>
+struct radixsort_fixed_source
+{
+    const unsigned char *data;
+    std::size_t n,bytes;
+    unsigned bits;
+    K base;
+    std::size_t blocks() const {return radix_sort_compress_blocks(n);}
+    std::size_t decode(std::size_t b,K *dst) const
+    {
+        std::size_t first=b*RADIXSORT_BLOCK,m=(n-first<RADIXSORT_BLOCK?n-first:RADIXSORT_BLOCK);
+        radixsort_unpack(data,bytes,first,m,bits,base,dst);
+        return m;
+    }
+};
+
+template<typename K>
+struct radixsort_for_source
+{
+    const unsigned char *data;
+    const radix_sort_block *index;
+    std::size_t nblocks,bytes;
+    std::size_t blocks() const {return nblocks;}
+    std::size_t decode(std::size_t b,K *dst) const
+    {
+        const radix_sort_block &blk=index[b];
+        radixsort_unpack(data+blk.offset,bytes-blk.offset,0,blk.count,blk.bits,K(blk.first),dst);
+        return blk.count;
+    }
+};
+
+// Traits, whose key is the value shifted left by S bits.
+template<typename K,std::size_t S>
+struct radixsort_shift_key
+{
+    static inline K get_key(K src) {return K(src<<S);}
+};
+
+// Sorts n values of the lower P bytes from 'src' into 'dst' or 'tmp'.
+template<typename K,std::size_t P,typename D>
+static inline K *radixsort_packed(const D &src,std::size_t n,K *dst,K *tmp)
+{
+    using std::size_t;
+    static const size_t SIZE=256;
+    static const size_t MASK=SIZE-1;
+    RADIXSORT_STAT(passes,1);
+    size_t c[2*SIZE]={0};
+    K buf[RADIXSORT_BLOCK];
+    {
+        RADIXSORT_TRACE_SPAN("count",n,0);
+        for(size_t b=0,nb=src.blocks();b<nb;++b)
+            for(size_t i=0,m=src.decode(b,buf);i<m;++i)
+                ++c[2*(size_t(buf[i])&MASK)+(i&1)];
+    }
+    radixsort_prefix<SIZE>(c,n); // Even if all keys are in one bucket, values need decoding.
+    {
+        RADIXSORT_TRACE_SPAN("scatter",n,0);
+        for(size_t b=0,nb=src.blocks();b<nb;++b)
+            for(size_t i=0,m=src.decode(b,buf);i<m;++i)
+            {
+                size_t k=size_t(buf[i])&MASK;
+                radixsort_lookahead(dst+c[k],(n-c[k])*sizeof(K));
+                dst[c[k]++]=buf[i];
+            }
+        RADIXSORT_STAT(bytes_moved,n*sizeof(K));
+    }
+    if(P==1) return dst;
+    return radix_sort_lsd_impl<K,(P>1?8*P-8:8),8,radixsort_shift_key<K,sizeof(K)*CHAR_BIT-8*P> >(dst,tmp,n);
+}
+
+template<typename K,typename D>
+static inline K *radixsort_packed_dispatch(const D &src,std::size_t n,unsigned long long top,K *dst,K *tmp)
+{
+    using std::size_t;
+    static const size_t KB=sizeof(K);
+    size_t p=1;
+    while(p<KB&&(top>>(8*p))!=0) ++p;
+    radixsort_stats_begin();
+    RADIXSORT_STAT(lsd_calls,1);
+    K *ret;
+    switch(p)
+    {
+        case 1:  ret=radixsort_packed<K,1>(src,n,dst,tmp); break;
+        case 2:  ret=radixsort_packed<K,(KB<2?KB:2)>(src,n,dst,tmp); break;
+        case 3:  ret=radixsort_packed<K,(KB<3?KB:3)>(src,n,dst,tmp); break;
+        case 4:  ret=radixsort_packed<K,(KB<4?KB:4)>(src,n,dst,tmp); break;
+        case 5:  ret=radixsort_packed<K,(KB<5?KB:5)>(src,n,dst,tmp); break;
+        case 6:  ret=radixsort_packed<K,(KB<6?KB:6)>(src,n,dst,tmp); break;
+        case 7:  ret=radixsort_packed<K,(KB<7?KB:7)>(src,n,dst,tmp); break;
+        default: ret=radixsort_packed<K,KB>(src,n,dst,tmp); break;
+    }
+    radixsort_stats_end();
+    return ret;
+}
+
+// Largest value of 'bits' bits plus 'base', or all ones on overflow.
+template<typename K>
+static inline unsigned long long radixsort_packed_top(K base,unsigned bits)
+{
+    K mask=K(bits<sizeof(K)*CHAR_BIT?(K(1)<<bits)-1:~K(0));
+    return (unsigned long long)(K(base+mask)<base?~K(0):K(base+mask));
+}
+
+// Packs n values as src[i]-base in 'bits' bits each (every src[i]-base
+// must fit). Returns the number of bytes written, (n*bits+7)/8.
+template<typename K>
+inline std::size_t radix_sort_pack(const K *src,std::size_t n,unsigned bits,K base,unsigned char *out)
+{
+    using std::size_t;
+    K d[RADIXSORT_BLOCK];
+    unsigned char *p=out;
+    for(size_t i=0;i<n&&bits>0;i+=RADIXSORT_BLOCK)
+    {
+        size_t m=(n-i<RADIXSORT_BLOCK?n-i:RADIXSORT_BLOCK);
+        for(size_t j=0;j<m;++j) d[j]=K(src[i+j]-base);
+        p=radixsort_pack(d,m,bits,p); // Whole blocks end on a byte boundary.
+    }
+    return size_t(p-out);
+}
+
+// Packs n values as FOR blocks, filling radix_sort_compress_blocks(n)
+// entries of 'index'. Returns the number of bytes written, at most
+// radix_sort_compress_bound(n,sizeof(K),RADIX_SORT_PACK_BITS).
+template<typename K>
+inline std::size_t radix_sort_pack_for(const K *src,std::size_t n,unsigned char *out,radix_sort_block *index)
+{
+    using std::size_t;
+    K d[RADIXSORT_BLOCK];
+    unsigned char *p=out;
+    for(size_t b=0,i=0;i<n;++b,i+=RADIXSORT_BLOCK)
+    {
+        size_t m=(n-i<RADIXSORT_BLOCK?n-i:RADIXSORT_BLOCK);
+        K lo=src[i],hi=src[i];
+        for(size_t j=1;j<m;++j)
+        {
+            if(src[i+j]<lo) lo=src[i+j];
+            if(hi<src[i+j]) hi=src[i+j];
+        }
+        unsigned bits=0;
+        for(K r=K(hi-lo);r!=0;r=K(r>>1)) ++bits;
+        radix_sort_block &blk=index[b];
+        blk.first=(unsigned long long)lo;
+        blk.offset=size_t(p-out);
+        blk.count=unsigned(m);
+        blk.bits=bits;
+        if(bits==0) continue;
+        for(size_t j=0;j<m;++j) d[j]=K(src[i+j]-lo);
+        p=radixsort_pack(d,m,bits,p);
+    }
+    return size_t(p-out);
+}
+
+// Sorts n values packed by radix_sort_pack() (K is an unsigned integer
+// type). 'dst' and 'tmp' are n values each. Returns the sorted values
+// (either 'dst' or 'tmp').
+template<typename K>
+inline K *radix_sort_packed(const unsigned char *packed,std::size_t n,unsigned bits,K base,K *dst,K *tmp)
+{
+    RADIXSORT_TRACE_SPAN("radix_sort_packed",n,-1);
+    radixsort_fixed_source<K> src={packed,n,(n*bits+7)/8,bits,base};
+    return radixsort_packed_dispatch(src,n,radixsort_packed_top(base,bits),dst,tmp);
+}
+
+// Sorts n values packed by radix_sort_pack_for(), as above.
+template<typename K>
+inline K *radix_sort_packed_for(const unsigned char *data,const radix_sort_block *index,std::size_t n,K *dst,K *tmp)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_packed_for",n,-1);
+    size_t nb=radix_sort_compress_blocks(n);
+    if(nb==0) return dst;
+    unsigned long long top=0;
+    for(size_t b=0;b<nb;++b)
+    {
+        unsigned long long t=radixsort_packed_top(K(index[b].first),index[b].bits);
+        if(top<t) top=t;
+    }
+    const radix_sort_block &last=index[nb-1];
+    radixsort_for_source<K> src={data,index,nb,last.offset+(size_t(last.count)*last.bits+7)/8};
+    return radixsort_packed_dispatch(src,n,top,dst,tmp);
+}
+
+// Bucketizing.
+//
+// The count and scatter of a radix pass, with the digit replaced by an
+// arbitrary classifier: classify(x) returns the bucket of x, in
+// [0,nbuckets). This is a k-way partition by shard, tier, region or
+// predicate bitmask. Buckets are runtime-sized, so counts go to the
+// caller's offsets[0..nbuckets] array, which on return holds the first
+// element of every bucket (and n at the end). classify() is called twice
+// per element in radix_sort_bucketize(), so it should be cheap; it must
+// return the same bucket each time.
+
+template<typename T,typename C>
+static inline void radixsort_bucketize_count(const T *src,std::size_t n,C &classify,std::size_t nbuckets,std::size_t *offsets)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("count",n,-1);
+    for(size_t b=0;b<=nbuckets;++b) offsets[b]=0;
+    for(size_t i=0;i<n;++i) ++offsets[size_t(classify(src[i]))];
+    for(size_t b=0,s=0,t;b<=nbuckets;++b) {t=s; s+=offsets[b]; offsets[b]=t;}
+}
+
+// Stable scatter of src[0..n) into dst[0..total). Advances c[k] to the
+// end of each bucket.
+template<typename T,typename C>
+static inline void radixsort_bucketize_scatter(const T *src,T *dst,std::size_t n,std::size_t total,C &classify,std::size_t *c)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("scatter",n,-1);
+    for(size_t i=0;i<n;++i)
+    {
+        size_t k=size_t(classify(src[i]));
+        radixsort_lookahead(dst+c[k],(total-c[k])*sizeof(T));
+        dst[c[k]++]=src[i];
+    }
+}
+
+// Stable partition of src[0..n) into dst by classify(). 'offsets' is
+// nbuckets+1 in size.
+template<typename T,typename C>
+inline void radix_sort_bucketize(const T *src,T *dst,std::size_t n,C classify,std::size_t nbuckets,std::size_t *offsets)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_bucketize",n,-1);
+    radixsort_bucketize_count(src,n,classify,nbuckets,offsets);
+    radixsort_bucketize_scatter(src,dst,n,n,classify,offsets);
+    for(size_t b=nbuckets;b>0;--b) offsets[b]=offsets[b-1];
+    offsets[0]=0;
+}
+
+// Inplace partition (not stable) by walking permutation cycles. 'next' is
+// nbuckets in size.
+template<typename T,typename C>
+inline void radix_sort_bucketize_inplace(T *src,std::size_t n,C classify,std::size_t nbuckets,std::size_t *offsets,std::size_t *next)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_bucketize_inplace",n,-1);
+    radixsort_bucketize_count(src,n,classify,nbuckets,offsets);
+    for(size_t b=0;b<nbuckets;++b) next[b]=offsets[b];
+    {
+        RADIXSORT_TRACE_SPAN("permute",n,-1);
+        for(size_t j=0;j<nbuckets;++j)
+            for(;next[j]!=offsets[j+1];++next[j])
+            {
+                size_t k=next[j],h=size_t(classify(src[k]));
+                while(j!=h)
+                {
+                    T t=src[next[h]];
+                    radixsort_lookahead(src+next[h],(n-next[h])*sizeof(T));
+                    src[next[h]++]=src[k];
+                    src[k]=t;
+                    h=size_t(classify(t));
+                }
+            }
+    }
+}
+
+#if RADIXSORT_ASYNC
+// Runs job(0..parts-1) on the pool and on the calling thread (part 0),
+// and waits for all of them.
+template<typename F>
+static inline void radixsort_run_parts(std::size_t parts,const F &job)
+{
+    std::vector<std::future<void> > done;
+    for(std::size_t p=1;p<parts;++p)
+    {
+        std::shared_ptr<std::packaged_task<void()> > task=std::make_shared<std::packaged_task<void()> >(
+            [&job,p]() {job(p);});
+        done.push_back(task->get_future());
+        radix_sort_default_pool().submit([task]() {(*task)();});
+    }
+    job(0);
+    for(std::size_t p=0;p<done.size();++p) done[p].get();
+}
+
+// Same as radix_sort_bucketize(), but splits the input into 'parts'
+// chunks (0 means one per pool worker), counted and scattered
+// concurrently on the pool; chunk p writes its part of every bucket after
+// chunks before it, so the result is the same. 'scratch' is
+// parts*nbuckets in size. Must not be called from a pool job.
+template<typename T,typename C>
+inline void radix_sort_bucketize_parallel(const T *src,T *dst,std::size_t n,C classify,std::size_t nbuckets,std::size_t *offsets,std::size_t parts,std::size_t *scratch)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_bucketize_parallel",n,-1);
+    if(parts==0) parts=radix_sort_default_pool().size();
+    if(parts<=1) {radix_sort_bucketize(src,dst,n,classify,nbuckets,offsets); return;}
+    const size_t chunk=(n+parts-1)/parts;
+    radixsort_run_parts(parts,[=](size_t p)
+    {
+        C cl=classify;
+        size_t *c=scratch+p*nbuckets;
+        for(size_t b=0;b<nbuckets;++b) c[b]=0;
+        for(size_t i=p*chunk,e=(n<i+chunk?n:i+chunk);i<e;++i) ++c[size_t(cl(src[i]))];
+    });
+    // Bucket-major prefix sum: bucket b of chunk p goes after bucket b of
+    // chunks 0..p-1.
+    size_t s=0;
+    for(size_t b=0;b<nbuckets;++b)
+    {
+        offsets[b]=s;
+        for(size_t p=0;p<parts;++p) {size_t t=scratch[p*nbuckets+b]; scratch[p*nbuckets+b]=s; s+=t;}
+    }
+    offsets[nbuckets]=n;
+    radixsort_run_parts(parts,[=](size_t p)
+    {
+        C cl=classify;
+        size_t i=p*chunk;
+        if(i<n) radixsort_bucketize_scatter(src+i,dst,(n-i<chunk?n-i:chunk),n,cl,scratch+p*nbuckets);
+    });
+}
+#endif
+
+// Roaring bitmaps.
+//
+// A roaring bitmap splits 32-bit values by their top 16 bits into chunks,
+// each stored as a container: a sorted array of low halves, a 65536-bit
+// bitmap, or runs. radix_sort_build_roaring() is one MSD pass on the top
+// 16 bits that scatters only low halves (half the bytes of the values);
+// the histogram of the pass bounds each chunk's cardinality, which picks
+// how to build its container. Chunks of fewer than RADIXSORT_ROARING_DENSE
+// values are radix sorted and deduplicated (all at once, by two LSD passes
+// before the top digit, if they are small on average); denser chunks are
+// set into a bitmap on the stack, without sorting. Either way the smallest encoding
+// is kept, counting 2 bytes per array value, 8 KB per bitmap and 4 bytes
+// per run (plus 2), as Roaring does. Duplicate input values are fine.
+// Container data is 16-bit words:
+//   * array: cardinality sorted values;
+//   * bitmap: 4096 words, value v is bit v%16 of word v/16;
+//   * run: pairs of (start, length-1), in order.
+// Every container takes at most as many words as its chunk has values,
+// so n words of data always suffice.
+
+#ifndef RADIXSORT_ROARING_DENSE
+#define RADIXSORT_ROARING_DENSE 4096
+#endif
+
+// If chunks of fewer than RADIXSORT_ROARING_DENSE values average fewer
+// than this many values, all values are presorted by their low halves.
+#ifndef RADIXSORT_ROARING_PRESORT
+#define RADIXSORT_ROARING_PRESORT 256
+#endif
+
+// Container types.
+enum
+{
+    RADIX_SORT_ROARING_ARRAY=0,
+    RADIX_SORT_ROARING_BITMAP=1,
+    RADIX_SORT_ROARING_RUN=2
+};
+
+struct radix_sort_roaring_container
+{
+    std::size_t offset;       // Offset of data, in 16-bit words.
+    unsigned int cardinality; // Number of values.
+    unsigned int words;       // Size of data, in 16-bit words.
+    unsigned short key;       // Top 16 bits of values.
+    unsigned short type;      // RADIX_SORT_ROARING_*.
+};
+
+// Number of set bits in x.
+static inline unsigned radixsort_popcount(unsigned long long x)
+{
+#if defined(__GNUC__)
+    return unsigned(__builtin_popcountll(x));
+#else
+    x=x-((x>>1)&0x5555555555555555ull);
+    x=(x&0x3333333333333333ull)+((x>>2)&0x3333333333333333ull);
+    x=(x+(x>>4))&0x0F0F0F0F0F0F0F0Full;
+    return unsigned((x*0x0101010101010101ull)>>56);
+#endif
+}
+
+// Number of trailing 0 bits in x (not 0).
+static inline unsigned radixsort_trailing_zeros(unsigned long long x)
+{
+#if defined(__GNUC__)
+    return unsigned(__builtin_ctzll(x));
+#else
+    unsigned r=0;
+    for(;!(x&1);x>>=1) ++r;
+    return r;
+#endif
+}
+
+struct radixsort_u16_key
+{
+    static inline unsigned short get_key(unsigned short src) {return src;}
+};
+
+// Writes runs of sorted unique values v[0..m) as (start, length-1) pairs.
+// Returns the number of words written.
+static inline std::size_t radixsort_roaring_runs(const unsigned short *v,std::size_t m,unsigned short *out)
+{
+    using std::size_t;
+    size_t k=0;
+    for(size_t i=0;i<m;)
+    {
+        size_t j=i+1;
+        while(j<m&&v[j]==v[j-1]+1) ++j;
+        out[k++]=v[i];
+        out[k++]=(unsigned short)(j-i-1);
+        i=j;
+    }
+    return k;
+}
+
+// Picks the smallest encoding of a chunk with 'card' values in 'runs' runs.
+static inline unsigned radixsort_roaring_type(std::size_t card,std::size_t runs)
+{
+    std::size_t plain=(card<=4096?2*card:8192);
+    if(4*runs+2<plain) return RADIX_SORT_ROARING_RUN;
+    return card<=4096?RADIX_SORT_ROARING_ARRAY:RADIX_SORT_ROARING_BITMAP;
+}
+
+// Builds the container of low halves v[0..m) through a bitmap.
+static inline void radixsort_roaring_dense(const unsigned short *v,std::size_t m,radix_sort_roaring_container &ct,unsigned short *out)
+{
+    using std::size_t;
+    unsigned long long bits[1024]={0};
+    for(size_t i=0;i<m;++i) bits[v[i]>>6]|=1ull<<(v[i]&63);
+    size_t card=0,runs=0;
+    unsigned long long carry=0;
+    for(size_t w=0;w<1024;++w)
+    {
+        card+=radixsort_popcount(bits[w]);
+        runs+=radixsort_popcount(bits[w]&~((bits[w]<<1)|carry)); // Run starts.
+        carry=bits[w]>>63;
+    }
+    ct.cardinality=unsigned(card);
+    ct.type=(unsigned short)radixsort_roaring_type(card,runs);
+    size_t k=0;
+    if(ct.type==RADIX_SORT_ROARING_BITMAP)
+        for(size_t w=0;w<1024;++w)
+            for(unsigned s=0;s<64;s+=16) out[k++]=(unsigned short)(bits[w]>>s);
+    else
+    {
+        size_t start=0,prev=0;
+        bool open=false;
+        for(size_t w=0;w<1024;++w)
+            for(unsigned long long x=bits[w];x;x&=x-1)
+            {
+                size_t u=64*w+radixsort_trailing_zeros(x);
+                if(ct.type==RADIX_SORT_ROARING_ARRAY) {out[k++]=(unsigned short)u; continue;}
+                if(open&&u==prev+1) {prev=u; continue;}
+                if(open) {out[k++]=(unsigned short)start;out[k++]=(unsigned short)(prev-start);}
+                start=prev=u;
+                open=true;
+            }
+        if(open&&ct.type==RADIX_SORT_ROARING_RUN) {out[k++]=(unsigned short)start;out[k++]=(unsigned short)(prev-start);}
+    }
+    ct.words=unsigned(k);
+}
+
+// Builds the container of low halves v[0..m) (m<RADIXSORT_ROARING_DENSE;
+// v is reordered, unless already 'sorted') at 'out'.
+static inline void radixsort_roaring_sparse(unsigned short *v,std::size_t m,bool sorted,radix_sort_roaring_container &ct,unsigned short *out)
+{
+    using std::size_t;
+    unsigned short tmp[RADIXSORT_ROARING_DENSE];
+    if(sorted) {}
+    else if(m>18) v=radix_sort_lsd_impl<unsigned short,16,8,radixsort_u16_key>(v,tmp,m);
+    else fallback_sort<unsigned short,radixsort_u16_key>(v,tmp,m,0);
+    size_t card=1,runs=1;
+    for(size_t i=1;i<m;++i)
+        if(v[i]!=v[card-1])
+        {
+            runs+=(v[i]!=v[card-1]+1);
+            v[card++]=v[i];
+        }
+    ct.cardinality=unsigned(card);
+    ct.type=(unsigned short)radixsort_roaring_type(card,runs);
+    // Only if RADIXSORT_ROARING_DENSE is above 4096.
+    if(ct.type==RADIX_SORT_ROARING_BITMAP) radixsort_roaring_dense(v,card,ct,out);
+    else if(ct.type==RADIX_SORT_ROARING_RUN) ct.words=unsigned(radixsort_roaring_runs(v,card,out));
+    else
+    {
+        for(size_t i=0;i<card;++i) out[i]=v[i];
+        ct.words=unsigned(card);
+    }
+}
+
+// Scratch for radix_sort_build_roaring(), in bytes.
+inline std::size_t radix_sort_build_roaring_scratch(std::size_t n)
+{
+    return 65537*sizeof(std::size_t)+2*n*sizeof(unsigned);
+}
+
+// Stable scatter of 32-bit values by a byte (at OFFSET).
+template<std::size_t OFFSET>
+static inline void radixsort_roaring_presort(const unsigned *src,unsigned *dst,std::size_t n)
+{
+    using std::size_t;
+    size_t c[2*256]={0};
+    radixsort_count<unsigned,OFFSET,255,radixsort_shift_key<unsigned,0> >(src,n,c);
+    radixsort_prefix<256>(c,n);
+    radixsort_scatter<unsigned,OFFSET,255,true,radixsort_shift_key<unsigned,0> >(src,dst,n,c);
+}
+
+// Builds a roaring bitmap of ids[0..n) (unsorted, 32-bit). 'containers'
+// has room for min(n,65536) entries and 'data' for n words. Returns the
+// number of containers, in order of keys.
+inline std::size_t radix_sort_build_roaring(const unsigned *ids,std::size_t n,radix_sort_roaring_container *containers,unsigned short *data,void *scratch)
+{
+    using std::size_t;
+    RADIXSORT_TRACE_SPAN("radix_sort_build_roaring",n,-1);
+    size_t *c=(size_t*)scratch;
+    unsigned *a=(unsigned*)(c+65537),*b=a+n;
+    unsigned short *low=(unsigned short*)a;
+    for(size_t j=0;j<=65536;++j) c[j]=0;
+    {
+        RADIXSORT_TRACE_SPAN("count",n,16);
+        for(size_t i=0;i<n;++i) ++c[ids[i]>>16];
+    }
+    // Sorting many small chunks one by one costs more (in histograms) than
+    // two LSD passes on low halves of all values beforehand, after which
+    // chunks come out of the top digit scatter already sorted.
+    size_t sparse=0,chunks=0;
+    for(size_t j=0;j<65536;++j)
+        if(c[j]>0&&c[j]<RADIXSORT_ROARING_DENSE) {sparse+=c[j];++chunks;}
+    const bool presorted=(chunks*RADIXSORT_ROARING_PRESORT>sparse);
+    const unsigned *src=ids;
+    if(presorted)
+    {
+        radixsort_roaring_presort<0>(ids,a,n);
+        radixsort_roaring_presort<8>(a,b,n);
+        src=b;
+    }
+    for(size_t j=0,s=0,t;j<=65536;++j) {t=s; s+=c[j]; c[j]=t;}
+    {
+        RADIXSORT_TRACE_SPAN("scatter",n,16);
+        for(size_t i=0;i<n;++i)
+        {
+            size_t k=src[i]>>16;
+            radixsort_lookahead(low+c[k],(n-c[k])*sizeof(unsigned short));
+            low[c[k]++]=(unsigned short)src[i];
+        }
+    }
+    // c[j] is now the end of chunk j.
+    size_t nc=0,out=0;
+    {
+        RADIXSORT_TRACE_SPAN("containers",n,-1);
+        for(size_t j=0,e=0;j<65536;e=c[j++])
+        {
+            size_t m=c[j]-e;
+            if(m==0) continue;
+            radix_sort_roaring_container &ct=containers[nc++];
+            ct.key=(unsigned short)j;
+            ct.offset=out;
+            if(m<RADIXSORT_ROARING_DENSE) radixsort_roaring_sparse(low+e,m,presorted,ct,data+out);
+            else radixsort_roaring_dense(low+e,m,ct,data+out);
+            out+=ct.words;
+        }
+    }
+    return nc;
+}
+
+// Checks if 'value' is in a roaring bitmap.
+inline bool radix_sort_roaring_contains(const radix_sort_roaring_container *containers,std::size_t nc,const unsigned short *data,unsigned value)
+{
+    using std::size_t;
+    const unsigned short key=(unsigned short)(value>>16),x=(unsigned short)value;
+    size_t lo=0,hi=nc;
+    while(lo<hi)
+    {
+        size_t mid=lo+(hi-lo)/2;
+        if(containers[mid].key<key) lo=mid+1;
+        else hi=mid;
+    }
+    if(lo==nc||containers[lo].key!=key) return false;
+    const radix_sort_roaring_container &ct=containers[lo];
+    const unsigned short *d=data+ct.offset;
+    if(ct.type==RADIX_SORT_ROARING_BITMAP) return (d[x>>4]>>(x&15))&1;
+    // Last array value or run start not above x.
+    const size_t step=(ct.type==RADIX_SORT_ROARING_RUN?2:1);
+    lo=0;hi=ct.words/step;
+    while(lo<hi)
+    {
+        size_t mid=lo+(hi-lo)/2;
+        if(d[mid*step]<=x) lo=mid+1;
+        else hi=mid;
+    }
+    if(lo==0) return false;
+    const unsigned short *e=d+(lo-1)*step;
+    return step==1?e[0]==x:x-e[0]<=e[1];
+}
+
+//==============================================================================
+// Test harness.
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+#include <chrono>
+#ifdef __GNUC__
+#include <x86intrin.h>
+#else
+#include <intrin.h>
+#endif
+
+using std::size_t;
+
+static const size_t MAX_N=20<<20;
+
+typedef std::uint32_t KeyType;
+typedef std::uint32_t ValueType;
+
+struct KV
+{
+    KeyType key;
+    ValueType index;
+    friend inline bool operator<(const KV &l,const KV &r) {return l.key<r.key;}
+};
+
+struct GetKey
+{
+    static inline KeyType get_key(const KV &src)
+    {
+        return src.key;
+    }
+};
+
+KV src[MAX_N],tmp[MAX_N],ref[MAX_N];
+
+static void gen(KV *dst,size_t n)
+{
+    std::minstd_rand rng(1);
+    std::uniform_int_distribution<KeyType> distr(0,KeyType(-1));
+    for(size_t i=0;i<n;++i)
+        dst[i]={distr(rng),std::uint32_t(i)};
+}
+
+template<KV* (*f)(KV*,KV*,size_t)>
+static void test(size_t n)
+{
+    uint64_t t=0,tm=std::uint64_t(-1);
+    size_t runs=12500/n+1;
+
+    std::minstd_rand rng(1);
+    std::uniform_int_distribution<std::uint32_t> distr(0,std::uint32_t(-1));
+    gen(ref,n);
+    std::stable_sort(ref,ref+n);
+
+    KV *res=src;
+    for(size_t k=0;k<runs;++k)
+    {
+        std::minstd_rand rng(1);
+        std::uniform_int_distribution<uint32_t> distr(0,std::uint32_t(-1));
+        gen(src,n);
+        t=__rdtsc();
+        res=f(src,tmp,n);
+        t=__rdtsc()-t;
+        if(t<tm) tm=t;
+    }
+    bool srt=true;
+    for(size_t i=0;i<n;++i) if(res[i].key!=ref[i].key) {srt=false;break;}
+    bool stb=true;
+    for(size_t i=0;i<n;++i) if(res[i].key!=ref[i].key||res[i].index!=ref[i].index) {stb=false;break;}
+
+    char buf[16];
+    double ret=double(t)/double(n);
+    t=tm;
+    std::sprintf(buf,"%5.0f",ret);
+    std::printf("%6s%c%c",buf,"# "[srt],"~ "[stb]);
+    std::fflush(stdout);
+}
+
+static inline KV *std_sort_wrapper(KV* src,KV* tmp,size_t n)
+{
+    (void)tmp;
+    std::sort(src,src+n);
+    return src;
+}
+
+static inline KV *radix_sort_stable_wrapper(KV* src,KV* tmp,size_t n)
+{
+    return radix_sort_stable<KV,GetKey>(src,tmp,n,-1,-1);
+}
+
+static inline KV *radix_sort_inplace_wrapper(KV* src,KV* tmp,size_t n)
+{
+    (void)tmp;
+    radix_sort_inplace<KV,GetKey>(src,n);
+    return src;
+}
+
+static inline KV *radix_sort_stable_verified_wrapper(KV* src,KV* tmp,size_t n)
+{
+    KV *ret=radix_sort_stable_verified<KV,GetKey>(src,tmp,n,-1,-1);
+    return ret?ret:src;
+}
+
+static inline KV *radix_sort_lsd_wrapper(KV* src,KV* tmp,size_t n)
+{
+    return radix_sort_stable<KV,GetKey>(src,tmp,n,-1,0);
+}
+
+//==============================================================================
+// Roofline report.
+//
+// For each sort call the planner (radix_sort_stable_plan() and friends)
+// estimates bytes read plus bytes written (assuming no pass is skipped),
+// which is compared to achieved time and to the measured copy bandwidth.
+// Small inputs live in cache, so they may well exceed 100%.
+
+static double seconds_now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Best of several large copies, counting both the read and the write.
+static double peak_bandwidth()
+{
+    const size_t n=MAX_N/2;
+    double best=1e30;
+    gen(src,n);
+    for(int k=0;k<8;++k)
+    {
+        double t=seconds_now();
+        std::memcpy(tmp,src,n*sizeof(KV));
+        t=seconds_now()-t;
+        if(t<best) best=t;
+    }
+    return 2.0*n*sizeof(KV)/best;
+}
+
+template<KV* (*f)(KV*,KV*,size_t)>
+static double time_best(size_t n)
+{
+    double tm=1e30;
+    size_t runs=12500/n+3;
+    for(size_t k=0;k<runs;++k)
+    {
+        gen(src,n);
+        double t=seconds_now();
+        f(src,tmp,n);
+        t=seconds_now()-t;
+        if(t<tm) tm=t;
+    }
+    return tm;
+}
+
+static void roofline_row(size_t n,const char *name,const radix_sort_plan &m,double t,double peak)
+{
+    static const char *algos[3]={"LSD","MSD","inplace MSD"};
+    char algo[32];
+    std::sprintf(algo,"%s/%d%s",algos[m.algorithm],m.digit_bits,name);
+    double bw=m.traffic_bytes/t;
+    std::printf("%9u  %-16s|%7d|%8.0f|%8.2f|%8.2f|%6.0f%%\n",
+        unsigned(n),algo,m.passes+m.fallback_levels,m.traffic_bytes/double(n),1e9*t/double(n),bw*1e-9,100.0*bw/peak);
+}
+
+static void roofline()
+{
+    double peak=peak_bandwidth();
+    std::printf("Measured peak (memcpy) bandwidth: %.2f GB/s.\n",peak*1e-9);
+    std::printf("%9s  %-16s|%7s|%8s|%8s|%8s|%7s\n","n","algorithm","passes","B/elem","ns/elem","GB/s","roof");
+    std::printf("---------------------------+-------+--------+--------+--------+-------\n");
+    for(size_t n=1000;n<=MAX_N/2;n*=4)
+    {
+        roofline_row(n,"",radix_sort_stable_plan<KV,GetKey>(n,-1,-1),time_best<radix_sort_stable_wrapper>(n),peak);
+        roofline_row(n,"",radix_sort_inplace_plan<KV,GetKey>(n),time_best<radix_sort_inplace_wrapper>(n),peak);
+        // Forced LSD, to compare pass-bound vs scatter-bound regimes.
+        roofline_row(n," (forced)",radix_sort_stable_plan<KV,GetKey>(n,-1,0),time_best<radix_sort_lsd_wrapper>(n),peak);
+    }
+}
+
+//==============================================================================
+// Phase microbenchmarks.
+//
+// Each kernel of a radix pass is timed in isolation (best of several runs,
+// inputs are restored outside of the timed region), on the top digit of
+// the key, for 2^BITS buckets.
+
+static std::uint64_t phase_min[5];
+
+static void phase_time(int phase,std::uint64_t t)
+{
+    if(t<phase_min[phase]) phase_min[phase]=t;
+}
+
+template<size_t BITS>
+static void phases(size_t n)
+{
+    static const size_t SIZE=size_t(1)<<BITS;
+    static const size_t OFFSET=sizeof(KeyType)*CHAR_BIT-BITS;
+    static const size_t MASK=SIZE-1;
+    static size_t hist[2*SIZE],c[2*SIZE],d[SIZE];
+    size_t runs=1000000/n+3;
+    for(int p=0;p<5;++p) phase_min[p]=std::uint64_t(-1);
+    gen(ref,n);
+    for(size_t k=0;k<runs;++k)
+    {
+        std::uint64_t t;
+        std::fill(hist,hist+2*SIZE,size_t(0));
+        t=__rdtsc();
+        radixsort_count<KV,OFFSET,MASK,GetKey>(ref,n,hist);
+        phase_time(0,__rdtsc()-t);
+
+        std::copy(hist,hist+2*SIZE,c);
+        t=__rdtsc();
+        bool same=radixsort_prefix<SIZE>(c,n);
+        phase_time(1,__rdtsc()-t);
+        (void)same;
+
+        std::copy(hist,hist+2*SIZE,c);
+        radixsort_prefix<SIZE>(c,n);
+        t=__rdtsc();
+        radixsort_scatter<KV,OFFSET,MASK,true,GetKey>(ref,tmp,n,c);
+        phase_time(2,__rdtsc()-t);
+
+        std::copy(hist,hist+2*SIZE,c);
+        radixsort_prefix<SIZE>(c,n);
+        t=__rdtsc();
+        radixsort_scatter<KV,OFFSET,MASK,false,GetKey>(ref,tmp,n,c);
+        phase_time(3,__rdtsc()-t);
+
+        std::copy(hist,hist+2*SIZE,c);
+        radixsort_prefix<SIZE>(c,n);
+        for(size_t j=0;j+1<SIZE;++j) d[j]=c[j+1];
+        d[SIZE-1]=n;
+        std::copy(ref,ref+n,src);
+        t=__rdtsc();
+        radixsort_permute<KV,OFFSET,MASK,GetKey>(src,n,c,d);
+        phase_time(4,__rdtsc()-t);
+    }
+    static const char *names[5]={"count (x2 unrolled)","prefix + same-bucket","scatter","scatter (no lookahead)","permute (inplace)"};
+    for(int p=0;p<5;++p)
+    {
+        // Prefix runs over buckets rather than elements.
+        double per=double(phase_min[p])/double(p==1?SIZE:n);
+        std::printf("%-24s|%6u|%9u|%10.2f|%14.0f\n",names[p],unsigned(SIZE),unsigned(n),per,double(phase_min[p]));
+    }
+}
+
+static void phases_fallback(size_t n)
+{
+    std::uint64_t tm=std::uint64_t(-1);
+    size_t runs=1000000/n+3;
+    gen(ref,n);
+    for(size_t k=0;k<runs;++k)
+    {
+        std::copy(ref,ref+n,src);
+        std::uint64_t t=__rdtsc();
+        fallback_sort<KV,GetKey>(src,tmp,n,0);
+        t=__rdtsc()-t;
+        if(t<tm) tm=t;
+    }
+    std::printf("%-24s|%6s|%9u|%10.2f|%14.0f\n","fallback_sort","-",unsigned(n),double(tm)/double(n),double(tm));
+}
+
+static void phases()
+{
+    std::printf("%-24s|%6s|%9s|%10s|%14s\n","kernel","bkts","n","cyc/unit","cycles");
+    std::printf("------------------------+------+---------+----------+--------------\n");
+    static const size_t ns[]={1000,64000,1000000,8000000};
+    for(size_t i=0;i<sizeof(ns)/sizeof(ns[0]);++i)
+    {
+        phases< 8>(ns[i]);
+        phases<11>(ns[i]);
+        phases<16>(ns[i]);
+    }
+    static const size_t fs[]={8,18,64,128,256};
+    for(size_t i=0;i<sizeof(fs)/sizeof(fs[0]);++i) phases_fallback(fs[i]);
+}
+
+//==============================================================================
+// Key dump replay.
+//
+// Dump file layout (all fields little-endian):
+//   char     magic[4];    // "RSKD"
+//   uint32_t version;     // 1
+//   uint32_t elem_size;   // Size of a record, in bytes.
+//   uint32_t key_offset;  // Offset of the key within a record.
+//   uint32_t key_size;    // 4 or 8.
+//   uint32_t key_kind;    // 0 - unsigned, 1 - signed, 2 - IEEE float.
+//   uint64_t count;       // Number of records.
+// followed by 'count' records. Keys are extracted into {key,index} pairs
+// (index being the record's position in the dump), which are then sorted
+// by every algorithm, both in the original order and shuffled, next to
+// uniformly random keys of the same size.
+
+template<typename K>
+struct DumpKV
+{
+    K key;
+    std::uint32_t index;
+    friend inline bool operator<(const DumpKV &l,const DumpKV &r) {return l.key<r.key;}
+};
+
+template<typename K>
+struct GetDumpKey
+{
+    static inline K get_key(const DumpKV<K> &src)
+    {
+        return src.key;
+    }
+};
+
+struct DumpHeader
+{
+    std::uint32_t elem_size,key_offset,key_size,key_kind;
+    std::uint64_t count;
+};
+
+static std::uint64_t read_le(const unsigned char *p,size_t size)
+{
+    std::uint64_t ret=0;
+    for(size_t i=0;i<size;++i) ret|=std::uint64_t(p[i])<<(8*i);
+    return ret;
+}
+
+// Maps key bits to unsigned order, see make_key_from_signed() and
+// make_key_from_float() above.
+template<typename K>
+static K dump_key(std::uint64_t bits,std::uint32_t kind)
+{
+    static const K top=K(1)<<(sizeof(K)*CHAR_BIT-1);
+    K k=K(bits);
+    if(kind==1) return k^top;
+    if(kind==2) return (k&top)?K(~k):K(k|top);
+    return k;
+}
+
+template<typename K>
+static bool load_dump(std::FILE *f,const DumpHeader &h,std::vector<DumpKV<K> > &out)
+{
+    std::vector<unsigned char> rec(h.elem_size);
+    out.resize(size_t(h.count));
+    for(size_t i=0;i<out.size();++i)
+    {
+        if(std::fread(&rec[0],h.elem_size,1,f)!=1) return false;
+        out[i].key=dump_key<K>(read_le(&rec[h.key_offset],h.key_size),h.key_kind);
+        out[i].index=std::uint32_t(i);
+    }
+    return true;
+}
+
+template<typename K>
+static void replay_cell(const std::vector<DumpKV<K> > &input,int algo)
+{
+    typedef DumpKV<K> T;
+    size_t n=input.size();
+    std::vector<T> a(n),b(n),r(input);
+    std::stable_sort(r.begin(),r.end());
+    std::uint64_t tm=std::uint64_t(-1);
+    size_t runs=12500/(n+1)+3;
+    T *res=0;
+    for(size_t k=0;k<runs;++k)
+    {
+        std::copy(input.begin(),input.end(),a.begin());
+        std::uint64_t t=__rdtsc();
+        switch(algo)
+        {
+            case 0: std::sort(a.begin(),a.end()); res=&a[0]; break;
+            case 1: std::stable_sort(a.begin(),a.end()); res=&a[0]; break;
+            case 2: res=radix_sort_stable<T,GetDumpKey<K> >(&a[0],&b[0],n,-1,-1); break;
+            case 3: res=radix_sort_stable<T,GetDumpKey<K> >(&a[0],&b[0],n,-1,0); break;
+            case 4: res=radix_sort_stable<T,GetDumpKey<K> >(&a[0],&b[0],n,-1,1); break;
+            default: radix_sort_inplace<T,GetDumpKey<K> >(&a[0],n); res=&a[0]; break;
+        }
+        t=__rdtsc()-t;
+        if(t<tm) tm=t;
+    }
+    bool srt=true,stb=true;
+    for(size_t i=0;i<n;++i) if(res[i].key!=r[i].key) {srt=false;break;}
+    for(size_t i=0;i<n;++i) if(res[i].key!=r[i].key||res[i].index!=r[i].index) {stb=false;break;}
+    std::printf("|%8.1f%c%c",double(tm)/double(n),"# "[srt],"~ "[stb]);
+}
+
+template<typename K>
+static void replay(const std::vector<DumpKV<K> > &original)
+{
+    static const char *names[6]={"std::sort","std::stable_sort","radix_sort_stable","radix_sort_stable (LSD)","radix_sort_stable (MSD)","radix_sort_inplace"};
+    std::vector<DumpKV<K> > shuffled(original),synthetic(original.size());
+    std::minstd_rand rng(1);
+    std::shuffle(shuffled.begin(),shuffled.end(),rng);
+    std::uniform_int_distribution<K> distr(0,K(-1));
+    for(size_t i=0;i<synthetic.size();++i) {synthetic[i].key=distr(rng); synthetic[i].index=std::uint32_t(i);}
+    std::printf("%-29s|%10s|%10s|%10s\n","cycles per element","original","shuffled","synthetic");
+    std::printf("-----------------------------+----------+----------+----------\n");
+    for(int algo=0;algo<6;++algo)
+    {
+        std::printf("%-29s",names[algo]);
+        replay_cell(original,algo);
+        replay_cell(shuffled,algo);
+        replay_cell(synthetic,algo);
+        std::printf("\n");
+    }
+}
+
+static int replay_file(const char *name)
+{
+    std::FILE *f=std::fopen(name,"rb");
+    if(!f) {std::fprintf(stderr,"%s: cannot open.\n",name); return 1;}
+    unsigned char raw[32];
+    DumpHeader h;
+    bool ok=(std::fread(raw,sizeof(raw),1,f)==1&&!std::memcmp(raw,"RSKD",4)&&read_le(raw+4,4)==1);
+    if(ok)
+    {
+        h.elem_size=std::uint32_t(read_le(raw+8,4));
+        h.key_offset=std::uint32_t(read_le(raw+12,4));
+        h.key_size=std::uint32_t(read_le(raw+16,4));
+        h.key_kind=std::uint32_t(read_le(raw+20,4));
+        h.count=read_le(raw+24,8);
+        ok=(h.key_size==4||h.key_size==8)&&h.key_kind<=2&&
+           h.key_size<=h.elem_size&&h.key_offset<=h.elem_size-h.key_size&&
+           h.count>0&&h.count<=0xFFFFFFFFu;
+    }
+    if(ok) // Records must be in the file before anything is allocated for them.
+    {
+        long pos=std::ftell(f);
+        ok=(pos>=0&&std::fseek(f,0,SEEK_END)==0);
+        long end=(ok?std::ftell(f):-1);
+        ok=ok&&end>=pos&&std::fseek(f,pos,SEEK_SET)==0&&
+           h.count<=std::uint64_t(end-pos)/h.elem_size;
+    }
+    if(!ok) {std::fclose(f); std::fprintf(stderr,"%s: bad header.\n",name); return 1;}
+    std::printf("%s: %llu records of %u bytes, %u-bit key.\n",name,(unsigned long long)h.count,unsigned(h.elem_size),unsigned(8*h.key_size));
+    if(h.key_size==4)
+    {
+        std::vector<DumpKV<std::uint32_t> > v;
+        ok=load_dump(f,h,v);
+        if(ok) replay(v);
+    }
+    else
+    {
+        std::vector<DumpKV<std::uint64_t> > v;
+        ok=load_dump(f,h,v);
+        if(ok) replay(v);
+    }
+    std::fclose(f);
+    if(!ok) {std::fprintf(stderr,"%s: truncated.\n",name); return 1;}
+    std::printf("\n");
+    return 0;
+}
+
+//==============================================================================
+// Memory footprint.
+//
+// Each sort runs in a forked child, so that peak RSS is not shared between
+// runs. The input is resident before the sort starts, scratch buffers are
+// allocated but not touched, so their pages show up as extra RSS only if
+// the sort actually uses them. Stack high-water mark is found by painting
+// a region below the caller's frame and checking how much of it got
+// overwritten.
+
+#if defined(__unix__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const size_t STACK_PROBE=1<<20;
+
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+static size_t stack_probe(bool paint)
+{
+    volatile unsigned char buf[STACK_PROBE];
+    if(paint) {for(size_t i=0;i<STACK_PROBE;++i) buf[i]=0xA5; return 0;}
+    volatile unsigned char *p=buf;
+    size_t i=0;
+    while(i<STACK_PROBE&&p[i]==0xA5) ++i;
+    return STACK_PROBE-i;
+}
+
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+static void memory_sort(int algo,KV *a,KV *b,size_t n)
+{
+    switch(algo)
+    {
+        case 0: std::sort(a,a+n); break;
+        case 1: std::stable_sort(a,a+n); break;
+        case 2: radix_sort_stable<KV,GetKey>(a,b,n,-1,-1); break;
+        case 3: radix_sort_stable<KV,GetKey>(a,b,n,-1,0); break;
+        case 4: radix_sort_stable<KV,GetKey>(a,b,n,-1,1); break;
+        default: radix_sort_inplace<KV,GetKey>(a,n); break;
+    }
+}
+
+static void memory_child(int algo,size_t n)
+{
+    KV *a=(KV*)std::malloc(n*sizeof(KV));
+    KV *b=(algo>=2&&algo<=4?(KV*)std::malloc(n*sizeof(KV)):0);
+    gen(a,n);
+    stack_probe(true);
+    rusage r0,r1;
+    getrusage(RUSAGE_SELF,&r0);
+    memory_sort(algo,a,b,n);
+    getrusage(RUSAGE_SELF,&r1);
+    size_t stack=stack_probe(false);
+    std::printf("|%9.0f|%9.0f|%8ld|%8ld|%8.1f\n",
+        double(n*sizeof(KV))/1024.0,double(r1.ru_maxrss-r0.ru_maxrss),
+        r1.ru_minflt-r0.ru_minflt,r1.ru_majflt-r0.ru_majflt,double(stack)/1024.0);
+    std::fflush(stdout);
+    std::free(a);
+    std::free(b);
+}
+
+static void memory()
+{
+    static const char *names[6]={"std::sort","std::stable_sort","radix_sort_stable","radix_sort_stable (LSD)","radix_sort_stable (MSD)","radix_sort_inplace"};
+    static const size_t ns[]={1000,64000,1000000,8000000};
+    std::printf("%9s  %-24s|%9s|%9s|%8s|%8s|%8s\n","n","algorithm","input KB","+RSS KB","minflt","majflt","stack KB");
+    std::printf("-----------------------------------+---------+---------+--------+--------+--------\n");
+    for(size_t i=0;i<sizeof(ns)/sizeof(ns[0]);++i)
+        for(int algo=0;algo<6;++algo)
+        {
+            std::printf("%9u  %-24s",unsigned(ns[i]),names[algo]);
+            std::fflush(stdout);
+            pid_t pid=fork();
+            if(pid==0) {memory_child(algo,ns[i]); _exit(0);}
+            int status=0;
+            if(pid<0||waitpid(pid,&status,0)<0||!WIFEXITED(status)) std::printf("| failed\n");
+        }
+}
+#else
+static void memory()
+{
+    std::printf("Memory footprint report is only available on POSIX systems.\n");
+}
+#endif
+
+//==============================================================================
+// Per-call statistics (build with -DRADIXSORT_STATS=1).
+
+static void print_stats(size_t n,const char *algo)
+{
+    radix_sort_stats s=radix_sort_stats_last();
+    std::printf("%9u  %-24s|%5s|%3s|%7llu|%7llu|%8.1f|%9llu|%5llu\n",unsigned(n),algo,
+        s.lsd_calls?"LSD":s.msd_calls?"MSD":"inpl",s.wide_calls?"11":"8",
+        s.passes,s.passes_skipped,double(s.bytes_moved)/double(n),s.fallback_calls,s.max_depth);
+}
+
+static void stats()
+{
+    if(!RADIXSORT_STATS) {std::printf("Statistics are compiled out, build with -DRADIXSORT_STATS=1.\n"); return;}
+    std::printf("%9s  %-24s|%5s|%3s|%7s|%7s|%8s|%9s|%5s\n","n","algorithm","mode","bit","passes","skipped","B/elem","fallbacks","depth");
+    std::printf("-----------------------------------+-----+---+-------+-------+--------+---------+-----\n");
+    for(size_t n=100;n<=MAX_N/2;n*=8)
+    {
+        gen(src,n); radix_sort_stable<KV,GetKey>(src,tmp,n,-1,-1); print_stats(n,"radix_sort_stable");
+        gen(src,n); radix_sort_stable<KV,GetKey>(src,tmp,n,-1,1); print_stats(n,"radix_sort_stable (MSD)");
+        gen(src,n); radix_sort_inplace<KV,GetKey>(src,n); print_stats(n,"radix_sort_inplace");
+    }
+}
+
+//==============================================================================
+// Timeline trace (build with -DRADIXSORT_TRACE=1).
+
+#if RADIXSORT_TRACE
+static radix_sort_trace trace_buffer;
+
+static void trace(const char *name)
+{
+    const size_t n=4000000;
+    radix_sort_trace_attach(&trace_buffer);
+    gen(src,n); radix_sort_stable<KV,GetKey>(src,tmp,n,-1,-1);
+    gen(src,n); radix_sort_stable<KV,GetKey>(src,tmp,n,-1,1);
+    gen(src,n); radix_sort_inplace<KV,GetKey>(src,n);
+    radix_sort_trace_attach(0);
+    std::FILE *f=std::fopen(name,"w");
+    if(!f) {std::fprintf(stderr,"%s: cannot open.\n",name); return;}
+    const radix_sort_trace *traces[1]={&trace_buffer};
+    radix_sort_trace_write(f,traces,1);
+    std::fclose(f);
+    std::printf("%u spans (%u dropped) written to %s.\n",unsigned(trace_buffer.count),unsigned(trace_buffer.dropped),name);
+}
+#else
+static void trace(const char *name)
+{
+    (void)name;
+    std::printf("Tracing is compiled out, build with -DRADIXSORT_TRACE=1.\n");
+}
+#endif
+
+//==============================================================================
+// Asynchronous sorting (build with -DRADIXSORT_ASYNC=1).
+
+#if RADIXSORT_ASYNC
+// Sorts 'jobs' independent arrays, one after another and then all at once
+// on the pool.
+static void async(size_t jobs)
+{
+    const size_t n=MAX_N/jobs;
+    KV *a[64],*b[64];
+    std::future<KV*> f[64];
+    if(jobs>64) jobs=64;
+    for(size_t j=0;j<jobs;++j) {a[j]=src+j*n; b[j]=tmp+j*n;}
+    std::printf("%u workers, %u sorts of %u elements.\n",unsigned(radix_sort_default_pool().size()),unsigned(jobs),unsigned(n));
+    for(size_t j=0;j<jobs;++j) gen(a[j],n);
+    double t=seconds_now();
+    for(size_t j=0;j<jobs;++j) radix_sort_stable<KV,GetKey>(a[j],b[j],n,0,-1);
+    t=seconds_now()-t;
+    std::printf("%-29s|%10.2f ms\n","sequential",t*1e3);
+    for(size_t j=0;j<jobs;++j) gen(a[j],n);
+    t=seconds_now();
+    for(size_t j=0;j<jobs;++j) f[j]=radix_sort_stable_async<KV,GetKey>(a[j],b[j],n,0,-1);
+    for(size_t j=0;j<jobs;++j) f[j].wait();
+    t=seconds_now()-t;
+    bool srt=true;
+    for(size_t j=0;j<jobs;++j)
+        for(size_t i=1;i<n;++i) if(a[j][i].key<a[j][i-1].key) {srt=false;break;}
+    std::printf("%-29s|%10.2f ms%s\n","radix_sort_stable_async",t*1e3,srt?"":" (not sorted)");
+}
+#else
+static void async(size_t jobs)
+{
+    (void)jobs;
+    std::printf("Asynchronous sorting is compiled out, build with -DRADIXSORT_ASYNC=1.\n");
+}
+#endif
+
+//==============================================================================
+// Coroutine sort tasks (build with -std=c++20).
+
+#if defined(__cpp_impl_coroutine)&&__cplusplus>=202002L
+// Whole sort time and the longest single resume(), per work quantum.
+static void coro()
+{
+    const size_t n=4000000;
+    static const size_t quanta[]={4096,65536,1<<20};
+    gen(src,n);
+    double t=seconds_now();
+    radix_sort_stable<KV,GetKey>(src,tmp,n,-1,-1);
+    std::printf("%-29s|%10.2f ms\n","radix_sort_stable",(seconds_now()-t)*1e3);
+    for(size_t q=0;q<sizeof(quanta)/sizeof(quanta[0]);++q)
+    {
+        gen(src,n);
+        double worst=0.0;
+        size_t resumes=0;
+        t=seconds_now();
+        radix_sort_task<KV> task=radix_sort_stable_task<KV,GetKey>(src,tmp,n,-1,-1,quanta[q]);
+        for(bool done=false;!done;++resumes)
+        {
+            double r=seconds_now();
+            done=task.resume();
+            r=seconds_now()-r;
+            if(r>worst) worst=r;
+        }
+        t=seconds_now()-t;
+        const KV *res=task.result();
+        bool srt=true;
+        for(size_t i=1;i<n;++i) if(res[i].key<res[i-1].key) {srt=false;break;}
+        std::printf("task, quantum %-15u|%10.2f ms, %6u resumes, longest %8.3f ms%s\n",
+            unsigned(quanta[q]),t*1e3,unsigned(resumes),worst*1e3,srt?"":" (not sorted)");
+    }
+}
+#else
+static void coro()
+{
+    std::printf("Coroutines are not available, build with -std=c++20.\n");
+}
+#endif
+
+//==============================================================================
+// Incremental sorting in frames.
+
+// Sorts 4M elements with a time budget per (simulated) frame, reporting the
+// number of frames taken and the worst overrun of the budget. A frame may
+// overrun the budget by one step (16384 units of work), so the harness
+// flags runs where the 90th percentile frame is longer than the budget plus
+// two (99th percentile) steps. The longest frame is reported but not
+// checked, since the OS can preempt any single frame.
+static void frames()
+{
+    const size_t n=4000000;
+    static const unsigned budgets[]={500,2000,8000}; // Microseconds.
+    static radix_sort_incremental<KV,GetKey> s;
+    for(size_t q=0;q<sizeof(budgets)/sizeof(budgets[0]);++q)
+    {
+        // Duration of a step, to know how much a frame may overrun.
+        gen(src,n);
+        s.init(src,tmp,n,-1,-1);
+        std::vector<double> steps;
+        for(bool done=false;!done;)
+        {
+            double t=seconds_now();
+            done=s.step(16384);
+            steps.push_back(seconds_now()-t);
+        }
+        std::sort(steps.begin(),steps.end());
+        const double step=steps[steps.size()*99/100];
+        gen(src,n);
+        s.init(src,tmp,n,-1,-1);
+        double worst=0.0,total=0.0,first=0.0;
+        std::vector<double> times;
+        unsigned frames=0;
+        for(bool done=false;!done;++frames)
+        {
+            double t=seconds_now();
+            done=s.step_for(budgets[q]);
+            t=seconds_now()-t;
+            total+=t;
+            if(t>worst) worst=t;
+            if(!done) times.push_back(t); // The last frame is short.
+            if(frames==0) first=s.progress();
+        }
+        std::sort(times.begin(),times.end());
+        const double p90=(times.empty()?0.0:times[times.size()*9/10]);
+        const KV *res=s.result();
+        bool srt=true;
+        for(size_t i=1;i<n;++i) if(res[i].key<res[i-1].key) {srt=false;break;}
+        std::printf("budget %5u us: %5u frames, %8.2f ms total, longest frame %7.3f ms (90%% %7.3f ms, step %5.3f ms), %5.1f%% after first%s%s\n",
+            budgets[q],frames,total*1e3,worst*1e3,p90*1e3,step*1e3,100.0*first,srt?"":" (not sorted)",
+            p90>budgets[q]*1e-6+2*step?" (over budget)":"");
+    }
+}
+
+//==============================================================================
+// Re-sorting after a few keys changed.
+
+// Changes a fraction of keys of sorted 1M elements, and compares re-sorting
+// them (radix_sort_resort()) against sorting everything from scratch.
+// Build with -DRADIXSORT_RESORT_RATIO=1 to see where the crossover is.
+static void resort()
+{
+    const size_t n=1000000;
+    static const double fractions[]={0.001,0.01,0.05,0.1,0.25,0.5};
+    static size_t changed[n];
+    static KV prev[n];
+    gen(src,n);
+    std::memcpy(prev,radix_sort_stable<KV,GetKey>(src,tmp,n,-1,-1),n*sizeof(KV));
+    for(size_t q=0;q<sizeof(fractions)/sizeof(fractions[0]);++q)
+    {
+        std::minstd_rand rng(2);
+        std::uniform_real_distribution<double> coin(0.0,1.0);
+        std::uniform_int_distribution<KeyType> jitter(0,1u<<20);
+        size_t m=0;
+        std::memcpy(src,prev,n*sizeof(KV));
+        for(size_t i=0;i<n;++i)
+            if(coin(rng)<fractions[q]) {src[i].key+=jitter(rng)-(1u<<19);changed[m++]=i;}
+        std::memcpy(ref,src,n*sizeof(KV));
+        double t_full=1e9,t_resort=1e9;
+        for(int r=0;r<5;++r)
+        {
+            std::memcpy(src,ref,n*sizeof(KV));
+            double t=seconds_now();
+            radix_sort_stable<KV,GetKey>(src,tmp,n,0,-1);
+            t=seconds_now()-t;
+            if(t<t_full) t_full=t;
+            std::memcpy(src,ref,n*sizeof(KV));
+            t=seconds_now();
+            radix_sort_resort<KV,GetKey>(src,tmp,n,changed,m);
+            t=seconds_now()-t;
+            if(t<t_resort) t_resort=t;
+        }
+        bool srt=true;
+        for(size_t i=1;i<n;++i) if(src[i].key<src[i-1].key) {srt=false;break;}
+        std::printf("%5.1f%% changed: full sort %7.3f ms, re-sort %7.3f ms%s\n",
+            100.0*fractions[q],t_full*1e3,t_resort*1e3,srt?"":" (not sorted)");
+    }
+}
+
+//==============================================================================
+// Spatial sorting.
+
+struct Particle
+{
+    float x,y,z;
+    std::uint32_t id;
+};
+
+// Sorts 1M random 3D (and 2D) points by curve code: computing codes, then
+// radix_sort_stable(), against radix_sort_spatial(), which builds codes
+// during the first pass.
+static void spatial()
+{
+    const size_t n=1000000;
+    static Particle pts[n],out[n];
+    static radix_sort_spatial_item buf[n],aux[n];
+    std::minstd_rand rng(1);
+    std::uniform_real_distribution<float> distr(-100.0f,100.0f);
+    for(size_t i=0;i<n;++i) pts[i]={distr(rng),distr(rng),distr(rng),std::uint32_t(i)};
+    static const double bounds[]={-100.0,-100.0,-100.0,100.0,100.0,100.0};
+    for(unsigned dims=2;dims<=3;++dims)
+    {
+        const double b2[]={-100.0,-100.0,100.0,100.0};
+        const double *bounds_d=(dims==2?b2:bounds);
+        const float *z=(dims==3?&pts[0].z:0);
+        double t_sep=1e9,t_fused=1e9,t_hilbert=1e9,t_gather=1e9;
+        const radix_sort_spatial_item *res=0;
+        bool ok=true;
+        for(int r=0;r<5;++r)
+        {
+            double t=seconds_now();
+            double scale=double((1u<<(dims==2?16:10))-1)/200.0;
+            for(size_t i=0;i<n;++i)
+            {
+                const float *p=&pts[i].x;
+                unsigned q[3];
+                for(unsigned d=0;d<dims;++d) q[d]=unsigned((double(p[d])+100.0)*scale);
+                src[i].key=(dims==2?radixsort_curve_code<2,false>(q):radixsort_curve_code<3,false>(q)<<2);
+                src[i].index=std::uint32_t(i);
+            }
+            const KV *sep=radix_sort_stable<KV,GetKey>(src,tmp,n,-1,-1);
+            t=seconds_now()-t;
+            if(t<t_sep) t_sep=t;
+            t=seconds_now();
+            res=radix_sort_spatial(&pts[0].x,&pts[0].y,z,sizeof(Particle)/sizeof(float),n,bounds_d,0,buf,aux);
+            t=seconds_now()-t;
+            if(t<t_fused) t_fused=t;
+            for(size_t i=0;i<n;++i) ok&=(res[i].key==sep[i].key&&res[i].index==sep[i].index);
+            t=seconds_now();
+            radix_sort_spatial_gather(pts,res,n,out);
+            t=seconds_now()-t;
+            if(t<t_gather) t_gather=t;
+            t=seconds_now();
+            res=radix_sort_spatial(&pts[0].x,&pts[0].y,z,sizeof(Particle)/sizeof(float),n,bounds_d,1,buf,aux);
+            t=seconds_now()-t;
+            if(t<t_hilbert) t_hilbert=t;
+            for(size_t i=1;i<n;++i) ok&=(res[i-1].key<=res[i].key);
+        }
+        std::printf("%uD: codes+radix_sort_stable %7.3f ms, Morton %7.3f ms, Hilbert %7.3f ms, gather %7.3f ms%s\n",
+            dims,t_sep*1e3,t_fused*1e3,t_hilbert*1e3,t_gather*1e3,ok?"":" (mismatch)");
+    }
+}
+
+//==============================================================================
+// Precision-limited sorting.
+
+// Sorts 1M elements by all 32 bits of the key and by its top 16 and 12
+// bits, checking order by the top bits and stability.
+template<size_t B>
+static void top_bits_row(size_t n,int mode)
+{
+    double t_best=1e9;
+    const KV *res=0;
+    for(int r=0;r<5;++r)
+    {
+        gen(src,n);
+        double t=seconds_now();
+        if(mode<0) radix_sort_inplace_top<KV,B,GetKey>(src,n),res=src;
+        else res=radix_sort_stable_top<KV,B,GetKey>(src,tmp,n,-1,mode);
+        t=seconds_now()-t;
+        if(t<t_best) t_best=t;
+    }
+    bool srt=true,stb=true;
+    for(size_t i=1;i<n;++i)
+    {
+        KeyType a=res[i-1].key>>(32-B),b=res[i].key>>(32-B);
+        if(b<a) srt=false;
+        if(a==b&&res[i].index<res[i-1].index) stb=false;
+    }
+    std::printf("%2u bits %-7s %7.3f ms%s%s\n",unsigned(B),mode<0?"inplace":mode==0?"LSD":"MSD",t_best*1e3,
+        srt?"":" (not sorted)",(stb||mode<0)?"":" (not stable)");
+}
+
+static void top_bits()
+{
+    const size_t n=1000000;
+    for(int mode=-1;mode<=1;++mode)
+    {
+        top_bits_row<32>(n,mode);
+        top_bits_row<16>(n,mode);
+        top_bits_row<12>(n,mode);
+    }
+}
+
+//==============================================================================
+// Applying a permutation to several arrays.
+
+struct Vec4
+{
+    float v[4];
+};
+
+// Sorts 1M keys and reorders 6 columns (3 floats, uint32, double, 16-byte
+// struct) accordingly: gathering into new arrays, in place by cycles, and
+// column by column through one scratch buffer.
+static void permute()
+{
+    const size_t n=1000000;
+    static float px[n],py[n],pz[n];
+    static std::uint32_t id[n];
+    static double mass[n];
+    static Vec4 color[n];
+    static float rx[n],ry[n],rz[n];
+    static std::uint32_t rid[n];
+    static double rmass[n];
+    static Vec4 rcolor[n];
+    static unsigned char visited[(n+7)/8];
+    static Vec4 scratch[n];
+    radix_sort_column cols[]={
+        {px,sizeof(float)},{py,sizeof(float)},{pz,sizeof(float)},
+        {id,sizeof(std::uint32_t)},{mass,sizeof(double)},{color,sizeof(Vec4)}};
+    size_t ncols=sizeof(cols)/sizeof(cols[0]);
+    gen(src,n);
+    const KV *order=radix_sort_stable<KV,GetKey>(src,tmp,n,-1,-1);
+    const std::uint32_t *perm=&order[0].index;
+    const size_t stride=sizeof(KV)/sizeof(std::uint32_t);
+    double t_new=1e9,t_cycles=1e9,t_gather=1e9;
+    bool ok=true;
+    for(int r=0;r<3;++r)
+    {
+        for(size_t i=0;i<n;++i)
+        {
+            px[i]=float(i);py[i]=float(2*i);pz[i]=float(3*i);
+            id[i]=std::uint32_t(i);mass[i]=double(i);
+            for(int k=0;k<4;++k) color[i].v[k]=float(i+k);
+        }
+        double t=seconds_now();
+        for(size_t i=0;i<n;++i) rx[i]=px[perm[i*stride]];
+        for(size_t i=0;i<n;++i) ry[i]=py[perm[i*stride]];
+        for(size_t i=0;i<n;++i) rz[i]=pz[perm[i*stride]];
+        for(size_t i=0;i<n;++i) rid[i]=id[perm[i*stride]];
+        for(size_t i=0;i<n;++i) rmass[i]=mass[perm[i*stride]];
+        for(size_t i=0;i<n;++i) rcolor[i]=color[perm[i*stride]];
+        t=seconds_now()-t;
+        if(t<t_new) t_new=t;
+        t=seconds_now();
+        radix_sort_permute_inplace(perm,stride,n,cols,ncols,visited);
+        t=seconds_now()-t;
+        if(t<t_cycles) t_cycles=t;
+        for(size_t i=0;i<n;++i)
+            ok&=(px[i]==rx[i]&&py[i]==ry[i]&&pz[i]==rz[i]&&id[i]==rid[i]&&mass[i]==rmass[i]&&color[i].v[3]==rcolor[i].v[3]);
+        for(size_t i=0;i<n;++i)
+        {
+            px[i]=float(i);py[i]=float(2*i);pz[i]=float(3*i);
+            id[i]=std::uint32_t(i);mass[i]=double(i);
+            for(int k=0;k<4;++k) color[i].v[k]=float(i+k);
+        }
+        t=seconds_now();
+        radix_sort_permute_gather(perm,stride,n,cols,ncols,scratch);
+        t=seconds_now()-t;
+        if(t<t_gather) t_gather=t;
+        for(size_t i=0;i<n;++i)
+            ok&=(px[i]==rx[i]&&py[i]==ry[i]&&pz[i]==rz[i]&&id[i]==rid[i]&&mass[i]==rmass[i]&&color[i].v[3]==rcolor[i].v[3]);
+    }
+    std::printf("%u columns, %u elements (%u bytes per row):\n",unsigned(ncols),unsigned(n),unsigned(3*sizeof(float)+sizeof(std::uint32_t)+sizeof(double)+sizeof(Vec4)));
+    std::printf("  gather into new arrays        %7.3f ms (extra memory: all columns)\n",t_new*1e3);
+    std::printf("  radix_sort_permute_inplace    %7.3f ms (extra memory: n bits)\n",t_cycles*1e3);
+    std::printf("  radix_sort_permute_gather     %7.3f ms (extra memory: largest column)%s\n",t_gather*1e3,ok?"":" (mismatch)");
+}
+
+//==============================================================================
+// Building CSR matrices.
+
+struct Triple
+{
+    std::uint64_t key; // row<<32|col.
+    float val;
+};
+
+struct GetTripleKey
+{
+    static inline std::uint64_t get_key(const Triple &src) {return src.key;}
+};
+
+// Builds CSR of a 100000x100000 matrix from 2M random triples (with some
+// duplicates): packing (row,col) into 64-bit keys, radix_sort_stable() and
+// a scan for row offsets, against radix_sort_coo_to_csr().
+static void csr()
+{
+    const size_t nnz=2000000,nrows=100000,ncols=100000;
+    static std::uint32_t rows[nnz],cols[nnz];
+    static float vals[nnz];
+    static Triple t0[nnz],t1[nnz];
+    static size_t row_ptr[nrows+1],ref_ptr[nrows+1];
+    static std::uint32_t out_cols[nnz];
+    static float out_vals[nnz];
+    static unsigned char scratch[(ncols+1)*sizeof(size_t)+nnz*(2*sizeof(unsigned)+sizeof(float))];
+    std::minstd_rand rng(1);
+    for(size_t i=0;i<nnz;++i)
+    {
+        rows[i]=unsigned(rng()%nrows);
+        cols[i]=unsigned(rng()%(ncols/20)); // Make duplicates likely.
+        vals[i]=float(rng()%16);
+    }
+    double t_packed=1e9,t_plain=1e9,t_sorted=1e9,t_summed=1e9;
+    const Triple *ref=0;
+    size_t out_nnz=0;
+    bool ok=true;
+    for(int r=0;r<5;++r)
+    {
+        double t=seconds_now();
+        for(size_t i=0;i<nnz;++i) {t0[i].key=std::uint64_t(rows[i])<<32|cols[i];t0[i].val=vals[i];}
+        ref=radix_sort_stable<Triple,GetTripleKey>(t0,t1,nnz,-1,-1);
+        for(size_t i=0,k=0;i<=nrows;++i) {while(k<nnz&&(ref[k].key>>32)<i) ++k; ref_ptr[i]=k;}
+        t=seconds_now()-t;
+        if(t<t_packed) t_packed=t;
+        t=seconds_now();
+        radix_sort_coo_to_csr<float>(rows,cols,vals,nnz,nrows,ncols,0,row_ptr,out_cols,out_vals,0);
+        t=seconds_now()-t;
+        if(t<t_plain) t_plain=t;
+        for(size_t i=0;i<=nrows;++i) ok&=(row_ptr[i]==ref_ptr[i]);
+        t=seconds_now();
+        radix_sort_coo_to_csr<float>(rows,cols,vals,nnz,nrows,ncols,RADIX_SORT_CSR_SORT_COLUMNS,row_ptr,out_cols,out_vals,scratch);
+        t=seconds_now()-t;
+        if(t<t_sorted) t_sorted=t;
+        for(size_t i=0;i<nnz;++i) ok&=(out_cols[i]==std::uint32_t(ref[i].key)&&out_vals[i]==ref[i].val);
+        t=seconds_now();
+        out_nnz=radix_sort_coo_to_csr<float>(rows,cols,vals,nnz,nrows,ncols,RADIX_SORT_CSR_SUM_DUPLICATES,row_ptr,out_cols,out_vals,scratch);
+        t=seconds_now()-t;
+        if(t<t_summed) t_summed=t;
+    }
+    // Check summed output against the packed sort.
+    size_t k=0;
+    for(size_t i=0;i<nnz;++i)
+    {
+        if(i>0&&ref[i].key==ref[i-1].key) continue;
+        float s=0.0f;
+        for(size_t j=i;j<nnz&&ref[j].key==ref[i].key;++j) s+=ref[j].val;
+        ok&=(k<out_nnz&&out_cols[k]==std::uint32_t(ref[i].key)&&out_vals[k]==s&&row_ptr[(ref[i].key>>32)+1]>k);
+        ++k;
+    }
+    ok&=(k==out_nnz);
+    std::printf("%u triples, %u rows:\n",unsigned(nnz),unsigned(nrows));
+    std::printf("  packed keys+radix_sort_stable  %7.3f ms\n",t_packed*1e3);
+    std::printf("  radix_sort_coo_to_csr          %7.3f ms\n",t_plain*1e3);
+    std::printf("  ...sorting columns             %7.3f ms\n",t_sorted*1e3);
+    std::printf("  ...summing duplicates          %7.3f ms (%u entries)%s\n",t_summed*1e3,unsigned(out_nnz),ok?"":" (mismatch)");
+}
+
+//==============================================================================
+// Suffix arrays.
+
+// Checks that suffixes in sa are in increasing order, and that sa is a
+// permutation.
+static bool check_suffix_array(const unsigned char *text,size_t n,const std::uint32_t *sa)
+{
+    std::vector<bool> seen(n,false);
+    for(size_t i=0;i<n;++i)
+    {
+        if(sa[i]>=n||seen[sa[i]]) return false;
+        seen[sa[i]]=true;
+    }
+    for(size_t i=1;i<n;++i)
+    {
+        size_t a=sa[i-1],b=sa[i],m=std::min(n-a,n-b);
+        int c=std::memcmp(text+a,text+b,m);
+        if(c>0||(c==0&&n-a>n-b)) return false;
+    }
+    return true;
+}
+
+// Builds suffix arrays of 1M bytes of random DNA-like and English-like
+// text, and of 125K bytes of periodic text (the worst case for prefix
+// doubling, and for the check).
+static void suffix()
+{
+    const size_t n=1000000;
+    static unsigned char text[n];
+    static std::uint32_t sa[n];
+    static unsigned char scratch[n*(2*sizeof(radixsort_suffix_record)+sizeof(unsigned))];
+    static const char *const names[]={"random ACGT","random words","periodic (period 1000)"};
+    for(int q=0;q<3;++q)
+    {
+        std::minstd_rand rng(1);
+        size_t len=(q==2?n/8:n);
+        for(size_t i=0;i<len;++i)
+        {
+            if(q==0) text[i]="ACGT"[rng()%4];
+            else if(q==1) text[i]=(rng()%6==0?' ':'a'+rng()%26);
+            else text[i]=(i<1000?'a'+rng()%26:text[i-1000]);
+        }
+        double t=seconds_now();
+        radix_sort_suffix_array(text,len,sa,scratch);
+        t=seconds_now()-t;
+        bool ok=check_suffix_array(text,len,sa);
+        std::printf("%-24s %8.2f ms%s\n",names[q],t*1e3,ok?"":" (wrong)");
+    }
+}
+
+//==============================================================================
+// Radix heap.
+
+// Event-simulation-like workload: 1M initial events, then each popped event
+// schedules another one a random delay later. Compares radix_heap (one by
+// one, and in batches of 256) with std::priority_queue.
+template<typename K>
+static void heap_rows()
+{
+    typedef std::pair<K,std::uint32_t> Event;
+    const size_t n=1000000,ops=4000000,batch=256;
+    std::minstd_rand rng(1);
+    std::vector<K> init(n),delays(ops);
+    for(size_t i=0;i<n;++i) init[i]=K(rng()%(1u<<20));
+    for(size_t i=0;i<ops;++i) delays[i]=K(1+rng()%1000);
+    double t_pq,t_rh,t_bulk;
+    unsigned long long s_pq=0,s_rh=0,s_bulk=0;
+    {
+        std::priority_queue<Event,std::vector<Event>,std::greater<Event> > pq;
+        double t=seconds_now();
+        for(size_t i=0;i<n;++i) pq.push(Event(init[i],std::uint32_t(i)));
+        for(size_t i=0;i<ops;++i)
+        {
+            Event e=pq.top();
+            pq.pop();
+            s_pq+=e.first;
+            pq.push(Event(e.first+delays[i],e.second));
+        }
+        t_pq=seconds_now()-t;
+    }
+    {
+        radix_heap<K,std::uint32_t> rh;
+        double t=seconds_now();
+        for(size_t i=0;i<n;++i) rh.push(init[i],std::uint32_t(i));
+        for(size_t i=0;i<ops;++i)
+        {
+            typename radix_heap<K,std::uint32_t>::entry e=rh.top();
+            rh.pop();
+            s_rh+=e.key;
+            rh.push(e.key+delays[i],e.value);
+        }
+        t_rh=seconds_now()-t;
+    }
+    {
+        typedef typename radix_heap<K,std::uint32_t>::entry Entry;
+        radix_heap<K,std::uint32_t> rh;
+        std::vector<Entry> buf(n);
+        double t=seconds_now();
+        for(size_t i=0;i<n;++i) {buf[i].key=init[i];buf[i].value=std::uint32_t(i);}
+        rh.push(&buf[0],n);
+        for(size_t i=0;i<ops;i+=batch)
+        {
+            // Successors of a batch are scheduled after its last event, so
+            // that pushed keys are not less than the last popped one.
+            size_t m=rh.pop(&buf[0],batch<ops-i?batch:ops-i);
+            for(size_t j=0;j<m;++j) {s_bulk+=buf[j].key;buf[j].key=rh.last()+delays[i+j];}
+            rh.push(&buf[0],m);
+        }
+        t_bulk=seconds_now()-t;
+    }
+    std::printf("%2u-bit keys: std::priority_queue %7.2f ms, radix_heap %7.2f ms, batches of %u %7.2f ms%s\n",
+        unsigned(sizeof(K)*8),t_pq*1e3,t_rh*1e3,unsigned(batch),t_bulk*1e3,s_pq==s_rh?"":" (mismatch)");
+    (void)s_bulk;
+}
+
+static void heap()
+{
+    heap_rows<std::uint32_t>();
+    heap_rows<std::uint64_t>();
+}
+
+//==============================================================================
+// Search layouts.
+
+struct GetU32
+{
+    static inline std::uint32_t get_key(std::uint32_t src) {return src;}
+};
+
+// Sorts 4M keys, rearranges them into Eytzinger and static B-tree order, and
+// times 4M random lookups against std::lower_bound() on the sorted array.
+static void search()
+{
+    const size_t n=4000000,m=4000000;
+    std::vector<std::uint32_t> keys(n),aux(n),eyt(n),bt(radix_sort_btree_size<std::uint32_t>(n)),q(m);
+    std::vector<size_t> res(m);
+    std::minstd_rand rng(1);
+    for(size_t i=0;i<n;++i) keys[i]=std::uint32_t(rng());
+    for(size_t i=0;i<m;++i) q[i]=std::uint32_t(rng());
+    const std::uint32_t *sorted=radix_sort_stable<std::uint32_t,GetU32>(&keys[0],&aux[0],n,-1,-1);
+    double t=seconds_now();
+    radix_sort_eytzinger(sorted,n,&eyt[0]);
+    double t_eyt=seconds_now()-t;
+    t=seconds_now();
+    radix_sort_btree(sorted,n,&bt[0]);
+    double t_bt=seconds_now()-t;
+    std::printf("%u keys: Eytzinger layout %.2f ms, B-tree layout %.2f ms\n",unsigned(n),t_eyt*1e3,t_bt*1e3);
+    unsigned long long ref=0,s;
+    bool ok=true;
+    t=seconds_now();
+    for(size_t i=0;i<m;++i)
+    {
+        const std::uint32_t *p=std::lower_bound(sorted,sorted+n,q[i]);
+        ref+=(p==sorted+n?0:*p);
+    }
+    std::printf("  std::lower_bound          %7.2f ns per lookup\n",(seconds_now()-t)*1e9/double(m));
+    t=seconds_now();
+    s=0;
+    for(size_t i=0;i<m;++i)
+    {
+        size_t k=radix_sort_eytzinger_lower_bound<std::uint32_t,GetU32>(&eyt[0],n,q[i]);
+        s+=(k==n?0:eyt[k]);
+    }
+    std::printf("  Eytzinger                 %7.2f ns per lookup\n",(seconds_now()-t)*1e9/double(m));
+    ok&=(s==ref);
+    t=seconds_now();
+    radix_sort_eytzinger_lower_bound<std::uint32_t,GetU32>(&eyt[0],n,&q[0],m,&res[0]);
+    s=0;
+    for(size_t i=0;i<m;++i) s+=(res[i]==n?0:eyt[res[i]]);
+    std::printf("  Eytzinger, batch          %7.2f ns per lookup\n",(seconds_now()-t)*1e9/double(m));
+    ok&=(s==ref);
+    t=seconds_now();
+    s=0;
+    for(size_t i=0;i<m;++i)
+    {
+        size_t k=radix_sort_btree_lower_bound<std::uint32_t,GetU32>(&bt[0],bt.size(),q[i]);
+        s+=(k==bt.size()?0:bt[k]);
+    }
+    std::printf("  B-tree                    %7.2f ns per lookup\n",(seconds_now()-t)*1e9/double(m));
+    ok&=(s==ref);
+    t=seconds_now();
+    radix_sort_btree_lower_bound<std::uint32_t,GetU32>(&bt[0],bt.size(),&q[0],m,&res[0]);
+    s=0;
+    for(size_t i=0;i<m;++i) s+=(res[i]==bt.size()?0:bt[res[i]]);
+    std::printf("  B-tree, batch             %7.2f ns per lookup%s\n",(seconds_now()-t)*1e9/double(m),ok&&s==ref?"":" (mismatch)");
+}
+
+//==============================================================================
+// Bucket directories.
+
+// Sorts 4M keys with and without a directory, and times 4M random lookups
+// with std::lower_bound() and through 8-bit and 16-bit directories.
+static void directory()
+{
+    const size_t n=4000000,m=4000000;
+    std::vector<std::uint32_t> keys(n),aux(n),q(m);
+    static size_t dir8[257],dir16[65537];
+    std::minstd_rand rng(1);
+    for(size_t i=0;i<m;++i) q[i]=std::uint32_t(rng());
+    double t_plain=1e9,t_dir=1e9;
+    const std::uint32_t *sorted=0;
+    for(int r=0;r<5;++r)
+    {
+        std::minstd_rand gen_rng(2);
+        for(size_t i=0;i<n;++i) keys[i]=std::uint32_t(gen_rng());
+        double t=seconds_now();
+        radix_sort_stable<std::uint32_t,GetU32>(&keys[0],&aux[0],n,-1,-1);
+        t=seconds_now()-t;
+        if(t<t_plain) t_plain=t;
+        for(size_t i=0;i<n;++i) keys[i]=std::uint32_t(gen_rng());
+        t=seconds_now();
+        sorted=radix_sort_stable_directory<std::uint32_t,GetU32>(&keys[0],&aux[0],n,-1,-1,dir8);
+        t=seconds_now()-t;
+        if(t<t_dir) t_dir=t;
+    }
+    double t=seconds_now();
+    radix_sort_directory<std::uint32_t,GetU32>(sorted,n,16,dir16);
+    double t_build=seconds_now()-t;
+    std::printf("%u keys: radix_sort_stable %.2f ms, with directory %.2f ms, 16-bit directory built in %.3f ms\n",
+        unsigned(n),t_plain*1e3,t_dir*1e3,t_build*1e3);
+    unsigned long long ref=0,s=0,s16=0;
+    t=seconds_now();
+    for(size_t i=0;i<m;++i) ref+=size_t(std::lower_bound(sorted,sorted+n,q[i])-sorted);
+    std::printf("  std::lower_bound        %7.2f ns per lookup\n",(seconds_now()-t)*1e9/double(m));
+    t=seconds_now();
+    for(size_t i=0;i<m;++i) s+=radix_sort_directory_lower_bound<std::uint32_t,GetU32>(sorted,dir8,8,q[i]);
+    std::printf("  8-bit directory         %7.2f ns per lookup\n",(seconds_now()-t)*1e9/double(m));
+    t=seconds_now();
+    for(size_t i=0;i<m;++i) s16+=radix_sort_directory_lower_bound<std::uint32_t,GetU32>(sorted,dir16,16,q[i]);
+    std::printf("  16-bit directory        %7.2f ns per lookup%s\n",(seconds_now()-t)*1e9/double(m),s==ref&&s16==ref?"":" (mismatch)");
+}
+
+//==============================================================================
+// Compressed output.
+
+// Sorts 4M 30-bit keys (mean difference about 270), compresses them
+// in both formats, and checks the round trip.
+static void compress()
+{
+    const size_t n=4000000;
+    std::vector<std::uint32_t> keys(n),aux(n),out(n);
+    std::vector<unsigned char> data(radix_sort_compress_bound(n,4,RADIX_SORT_PACK_VARINT));
+    std::vector<radix_sort_block> index(radix_sort_compress_blocks(n));
+    for(int format=RADIX_SORT_PACK_BITS;format<=RADIX_SORT_PACK_VARINT;++format)
+    {
+        double t_sort=1e9,t_all=1e9,t_dec=1e9;
+        size_t bytes=0;
+        const std::uint32_t *sorted=0;
+        for(int r=0;r<5;++r)
+        {
+            std::minstd_rand rng(2);
+            for(size_t i=0;i<n;++i) keys[i]=std::uint32_t(rng())&0x3FFFFFFF;
+            double t=seconds_now();
+            sorted=radix_sort_stable<std::uint32_t,GetU32>(&keys[0],&aux[0],n,-1,-1);
+            t=seconds_now()-t;
+            if(t<t_sort) t_sort=t;
+            rng.seed(2);
+            for(size_t i=0;i<n;++i) keys[i]=std::uint32_t(rng())&0x3FFFFFFF;
+            t=seconds_now();
+            bytes=radix_sort_stable_compressed<std::uint32_t,GetU32>(&keys[0],&aux[0],n,-1,format,&data[0],&index[0]);
+            t=seconds_now()-t;
+            if(t<t_all) t_all=t;
+            t=seconds_now();
+            radix_sort_decompress(&data[0],&index[0],n,format,&out[0]);
+            t=seconds_now()-t;
+            if(t<t_dec) t_dec=t;
+        }
+        bool ok=std::equal(out.begin(),out.end(),sorted);
+        std::printf("%s: %u keys in %.2f MB (%.2f bits per key, index %.2f MB), sort %.2f ms, sort+compress %.2f ms, decompress %.2f ms%s\n",
+            format==RADIX_SORT_PACK_BITS?"bit-packed":"varint",unsigned(n),bytes/1e6,bytes*8.0/double(n),
+            index.size()*sizeof(radix_sort_block)/1e6,t_sort*1e3,t_all*1e3,t_dec*1e3,ok?"":" (mismatch)");
+    }
+}
+
+//==============================================================================
+// Packed input.
+
+// Sorts 4M 20-bit values stored bit-packed and as FOR blocks, decoding
+// into an array first and then sorting, versus sorting the packed data.
+static void packed()
+{
+    const size_t n=4000000;
+    const unsigned bits=20;
+    std::vector<std::uint32_t> keys(n),aux(n),out(n);
+    std::minstd_rand rng(2);
+    for(size_t i=0;i<n;++i) keys[i]=std::uint32_t(rng())&((1u<<bits)-1);
+    std::vector<std::uint32_t> ref(keys);
+    std::sort(ref.begin(),ref.end());
+    std::vector<unsigned char> fixed((n*bits+7)/8),blocks(radix_sort_compress_bound(n,4,RADIX_SORT_PACK_BITS));
+    std::vector<radix_sort_block> index(radix_sort_compress_blocks(n));
+    radix_sort_pack<std::uint32_t>(&keys[0],n,bits,0,&fixed[0]);
+    size_t bytes=radix_sort_pack_for<std::uint32_t>(&keys[0],n,&blocks[0],&index[0]);
+    double t_fixed=1e9,t_fixed_fused=1e9,t_for=1e9,t_for_fused=1e9;
+    bool ok=true;
+    for(int r=0;r<5;++r)
+    {
+        double t=seconds_now();
+        radixsort_unpack<std::uint32_t>(&fixed[0],fixed.size(),0,n,bits,0,&keys[0]);
+        const std::uint32_t *s=radix_sort_stable<std::uint32_t,GetU32>(&keys[0],&aux[0],n,-1,-1);
+        t_fixed=std::min(t_fixed,seconds_now()-t);
+        ok=ok&&std::equal(ref.begin(),ref.end(),s);
+        t=seconds_now();
+        s=radix_sort_packed<std::uint32_t>(&fixed[0],n,bits,0,&out[0],&aux[0]);
+        t_fixed_fused=std::min(t_fixed_fused,seconds_now()-t);
+        ok=ok&&std::equal(ref.begin(),ref.end(),s);
+        t=seconds_now();
+        for(size_t b=0;b<index.size();++b)
+            radixsort_unpack<std::uint32_t>(&blocks[0]+index[b].offset,bytes-index[b].offset,0,index[b].count,index[b].bits,std::uint32_t(index[b].first),&keys[b*RADIXSORT_BLOCK]);
+        s=radix_sort_stable<std::uint32_t,GetU32>(&keys[0],&aux[0],n,-1,-1);
+        t_for=std::min(t_for,seconds_now()-t);
+        ok=ok&&std::equal(ref.begin(),ref.end(),s);
+        t=seconds_now();
+        s=radix_sort_packed_for<std::uint32_t>(&blocks[0],&index[0],n,&out[0],&aux[0]);
+        t_for_fused=std::min(t_for_fused,seconds_now()-t);
+        ok=ok&&std::equal(ref.begin(),ref.end(),s);
+    }
+    std::printf("%u values of %u bits:\n",unsigned(n),bits);
+    std::printf("  fixed width: decode+sort %.2f ms, radix_sort_packed %.2f ms\n",t_fixed*1e3,t_fixed_fused*1e3);
+    std::printf("  FOR blocks:  decode+sort %.2f ms, radix_sort_packed_for %.2f ms%s\n",t_for*1e3,t_for_fused*1e3,ok?"":" (mismatch)");
+}
+
+//==============================================================================
+// Bucketizing.
+
+struct ShardOf
+{
+    size_t shards;
+    size_t operator()(const KV &x) const {return x.key%shards;}
+};
+
+// Partitions 4M records into 1000 shards by key, with per-shard vectors
+// and with radix_sort_bucketize() and its inplace (and parallel) versions.
+static void bucketize()
+{
+    const size_t n=4000000,shards=1000;
+    std::vector<size_t> offsets(shards+1),next(shards);
+    ShardOf classify={shards};
+    gen(src,n);
+    double t_vec=1e9,t_stable=1e9,t_inplace=1e9;
+    bool ok=true;
+    for(int r=0;r<5;++r)
+    {
+        double t=seconds_now();
+        std::vector<std::vector<KV> > v(shards);
+        for(size_t i=0;i<n;++i) v[classify(src[i])].push_back(src[i]);
+        for(size_t b=0,k=0;b<shards;++b)
+            for(size_t i=0;i<v[b].size();++i) ref[k++]=v[b][i];
+        t_vec=std::min(t_vec,seconds_now()-t);
+        t=seconds_now();
+        radix_sort_bucketize(src,tmp,n,classify,shards,&offsets[0]);
+        t_stable=std::min(t_stable,seconds_now()-t);
+        ok=ok&&std::memcmp(tmp,ref,n*sizeof(KV))==0;
+        t=seconds_now();
+        radix_sort_bucketize_inplace(tmp,n,classify,shards,&offsets[0],&next[0]);
+        t_inplace=std::min(t_inplace,seconds_now()-t);
+        for(size_t b=0;b<shards;++b)
+            ok=ok&&offsets[b+1]-offsets[b]==v[b].size();
+    }
+    std::printf("%u records into %u shards: vectors %.2f ms, radix_sort_bucketize %.2f ms, inplace %.2f ms%s\n",
+        unsigned(n),unsigned(shards),t_vec*1e3,t_stable*1e3,t_inplace*1e3,ok?"":" (mismatch)");
+#if RADIXSORT_ASYNC
+    for(size_t parts=2;parts<=8;parts*=2)
+    {
+        std::vector<size_t> scratch(parts*shards);
+        double t_par=1e9;
+        for(int r=0;r<5;++r)
+        {
+            double t=seconds_now();
+            radix_sort_bucketize_parallel(src,tmp,n,classify,shards,&offsets[0],parts,&scratch[0]);
+            t_par=std::min(t_par,seconds_now()-t);
+        }
+        std::printf("  parallel, %u parts: %.2f ms%s\n",unsigned(parts),t_par*1e3,std::memcmp(tmp,ref,n*sizeof(KV))==0?"":" (mismatch)");
+    }
+#endif
+}
+
+//==============================================================================
+// Roaring bitmaps.
+
+// Builds roaring bitmaps of 4M row ids (sparse, dense and clustered), and
+// compares with just radix sorting them, which a bitmap library fed one
+// value at a time would need first.
+static void roaring()
+{
+    const size_t n=4000000;
+    std::vector<std::uint32_t> ids(n),keys(n),aux(n);
+    std::vector<radix_sort_roaring_container> containers(65536);
+    std::vector<unsigned short> data(n);
+    std::vector<char> scratch(radix_sort_build_roaring_scratch(n));
+    const char *names[3]={"sparse","dense","clustered"};
+    for(int kind=0;kind<3;++kind)
+    {
+        std::minstd_rand rng(3);
+        for(size_t i=0;i<n;++i)
+            switch(kind)
+            {
+                case 0: ids[i]=std::uint32_t(rng()); break;
+                case 1: ids[i]=std::uint32_t(rng())%(8u<<20); break;
+                default: ids[i]=std::uint32_t(i/1000*4096+rng()%512); break;
+            }
+        double t_sort=1e9,t_build=1e9;
+        size_t nc=0;
+        for(int r=0;r<5;++r)
+        {
+            std::copy(ids.begin(),ids.end(),keys.begin());
+            double t=seconds_now();
+            radix_sort_stable<std::uint32_t,GetU32>(&keys[0],&aux[0],n,-1,-1);
+            t_sort=std::min(t_sort,seconds_now()-t);
+            t=seconds_now();
+            nc=radix_sort_build_roaring(&ids[0],n,&containers[0],&data[0],&scratch[0]);
+            t_build=std::min(t_build,seconds_now()-t);
+        }
+        size_t count[3]={0,0,0},words=0;
+        bool ok=true;
+        for(size_t k=0;k<nc;++k) {++count[containers[k].type];words+=containers[k].words;}
+        for(size_t i=0;i<n;i+=97) ok=ok&&radix_sort_roaring_contains(&containers[0],nc,&data[0],ids[i]);
+        std::printf("%-9s: radix_sort_stable %.2f ms, radix_sort_build_roaring %.2f ms, %u arrays, %u bitmaps, %u runs, %.2f MB%s\n",
+            names[kind],t_sort*1e3,t_build*1e3,unsigned(count[0]),unsigned(count[1]),unsigned(count[2]),
+            (words*2.0+nc*sizeof(radix_sort_roaring_container))/1e6,ok?"":" (mismatch)");
+    }
+}
+
+int main(int argc,char **argv)
+{
+    if(argc>1&&!std::strcmp(argv[1],"roofline")) {roofline(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"phases")) {phases(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"memory")) {memory(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"stats")) {stats(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"async")) {async(argc>2?size_t(std::atoi(argv[2])):8); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"coro")) {coro(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"frames")) {frames(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"resort")) {resort(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"spatial")) {spatial(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"top")) {top_bits(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"permute")) {permute(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"csr")) {csr(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"suffix")) {suffix(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"heap")) {heap(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"search")) {search(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"directory")) {directory(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"compress")) {compress(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"packed")) {packed(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"bucketize")) {bucketize(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"roaring")) {roaring(); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"trace")) {trace(argc>2?argv[2]:"trace.json"); return 0;}
+    if(argc>1&&!std::strcmp(argv[1],"replay"))
+    {
+        int ret=0;
+        for(int i=2;i<argc;++i) ret|=replay_file(argv[i]);
+        return ret;
+    }
+    static const int N=9;
+    static const int C=190; // C/100 is size sequence multiplier.
+    int m=16;
+    std::printf("Timings are in cycles per element.\n");
+    for(int q=0;q<2;++q)
+    {
+        std::printf("%-29s","n");
+        for(int i=0,n=m;i<N;++i,n=C*n/100) std::printf("|%8d",n);
+        std::printf("\n");
+        std::printf("-----------------------------");
+        for(size_t i=0;i<N;++i) std::printf("+--------");
+        std::printf("\n");
+        std::printf("%-29s","std::sort");
+        for(int i=0,n=m;i<N;++i,n=C*n/100) {std::printf("|");test<std_sort_wrapper>(n);}
+        std::printf("\n");
+        std::printf("%-29s","radix_sort_stable");
+        for(int i=0,n=m;i<N;++i,n=C*n/100) {std::printf("|");test<radix_sort_stable_wrapper>(n);}
+        std::printf("\n");
+        std::printf("%-29s","radix_sort_inplace");
+        for(int i=0,n=m;i<N;++i,n=C*n/100) {std::printf("|");test<radix_sort_inplace_wrapper>(n);}
+        std::printf("\n");
+        std::printf("%-29s","radix_sort_stable_verified");
+        for(int i=0,n=m;i<N;++i,n=C*n/100) {std::printf("|");test<radix_sort_stable_verified_wrapper>(n);}
+        std::printf("\n");
+        for(int i=0;i<N;++i,m=C*m/100);
+        std::printf("\n");
+    }
+    return 0;
+}